@@ -119,6 +119,8 @@ static dboolean DL_ProcessAutomap(vtxlist_t* vl, int* drawcount) {
     leaf    = &leafs[sub->leaf];
     count   = *drawcount;
 
+    DL_ReserveVertices(count + sub->numleafs);
+
     for(j = 0; j < sub->numleafs - 2; j++) {
         dglTriangle(count, count + 1 + j, count + 2 + j);
     }
@@ -221,7 +223,10 @@ void AM_DrawLeafs(float scale) {
             //
             if(!(sub->sector->flags & MS_HIDESSECTOR) || am_fulldraw.value) {
                 vtxlist_t *list;
-                vtx_t *v = &drawVertex[0];
+                vtx_t *v;
+
+                DL_ReserveVertices(sub->numleafs);
+                v = &drawVertex[0];
 
                 for(j = 0; j < sub->numleafs; j++) {
                     vertex_t *vertex;
@@ -274,28 +279,56 @@ void AM_DrawLeafs(float scale) {
 
 //
 // AM_DrawLine
+// Lines are queued up and sent in one go by AM_FlushLines
 //
 
+static vtx_t *am_linevtx = NULL;
+static int am_linecount = 0;
+static int am_linemax = 0;
+
 void AM_DrawLine(int x1, int x2, int y1, int y2, float scale, rcolor c) {
-    vtx_t v[2];
+    vtx_t *v;
+
+    if(am_linecount + 2 > am_linemax) {
+        am_linemax += 1024;
+        am_linevtx = Z_Realloc(am_linevtx, am_linemax * sizeof(vtx_t), PU_STATIC, 0);
+    }
+
+    v = &am_linevtx[am_linecount];
 
     v[0].x = F2D3D(x1);
-    v[0].z = F2D3D(y1);
+    v[0].y = F2D3D(y1);
     v[1].x = F2D3D(x2);
-    v[1].z = F2D3D(y2);
+    v[1].y = F2D3D(y2);
 
-    v[0].y = v[1].y = (scale*2);
+    v[0].z = v[1].z = -(scale*2);
+    v[0].tu = v[0].tv = v[1].tu = v[1].tv = 0;
 
     dglSetVertexColor(v, c, 2);
 
+    am_linecount += 2;
+}
+
+//
+// AM_FlushLines
+//
+
+void AM_FlushLines(void) {
+    if(!am_linecount) {
+        return;
+    }
+
     dglDisable(GL_TEXTURE_2D);
-    dglBegin(GL_LINES);
-    dglColor4ub(v[0].r, v[0].g, v[0].b, v[0].a);
-    dglVertex3f(v[0].x, v[0].z, -v[0].y);
-    dglColor4ub(v[1].r, v[1].g, v[1].b, v[1].a);
-    dglVertex3f(v[1].x, v[1].z, -v[1].y);
-    dglEnd();
+    dglSetVertex(am_linevtx);
+    dglDrawArrays(GL_LINES, 0, am_linecount);
     dglEnable(GL_TEXTURE_2D);
+
+    if(devparm || timingdemo) {
+        vertCount += am_linecount;
+        glDrawCalls++;
+    }
+
+    am_linecount = 0;
 }
 
 //
@@ -355,7 +388,7 @@ void AM_DrawTriangle(mobj_t* mobj, float scale, dboolean solid, byte r, byte g,
         dglPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
     }
 
-    if(devparm) {
+    if(devparm || timingdemo) {
         vertCount += 3;
     }
 }
@@ -28,6 +28,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 #include "i_video.h"
 #include "z_zone.h"
 #include "doomdef.h"
@@ -90,6 +91,7 @@ static int      mpany;
 static angle_t  autoprevangle   = 0;
 static fixed_t  automapprevx    = 0;
 static fixed_t  automapprevy    = 0;
+static float    am_viewbox[4];              // visible area of the map in world units
 
 void AM_Start(void);
 
@@ -581,6 +583,77 @@ void AM_Ticker(void) {
     }
 }
 
+//
+// AM_GetViewBox
+// Bounding box of the area visible through the automap
+// camera. Uses the circle around the view rectangle so
+// it doesn't have to care about the view rotation
+//
+
+static void AM_GetViewBox(fixed_t x, fixed_t y, angle_t view) {
+    float dist;
+    float hw;
+    float hh;
+    float r;
+    float an;
+    float px;
+    float py;
+    float cx;
+    float cy;
+
+    //
+    // must match the projection setup in AM_BeginDraw
+    //
+    dist = scale * 2;
+    hh = dist * (float)tan(45.0f * M_PI / 360.0f);
+    hw = hh * ((float)video_width / (float)video_height);
+    r = (float)sqrt(hw * hw + hh * hh);
+
+    //
+    // the pan offset is applied in view space
+    //
+    an = TRUEANGLES(view) * (float)M_PI / 180.0f;
+    px = F2D3D(automappanx);
+    py = F2D3D(automappany);
+
+    cx = F2D3D(x) + (px * (float)cos(an) - py * (float)sin(an));
+    cy = F2D3D(y) + (px * (float)sin(an) + py * (float)cos(an));
+
+    am_viewbox[BOXLEFT]     = cx - r;
+    am_viewbox[BOXRIGHT]    = cx + r;
+    am_viewbox[BOXBOTTOM]   = cy - r;
+    am_viewbox[BOXTOP]      = cy + r;
+}
+
+//
+// AM_LineInView
+//
+
+static dboolean AM_LineInView(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2) {
+    float fx1 = F2D3D(x1);
+    float fy1 = F2D3D(y1);
+    float fx2 = F2D3D(x2);
+    float fy2 = F2D3D(y2);
+
+    if(fx1 < am_viewbox[BOXLEFT] && fx2 < am_viewbox[BOXLEFT]) {
+        return false;
+    }
+
+    if(fx1 > am_viewbox[BOXRIGHT] && fx2 > am_viewbox[BOXRIGHT]) {
+        return false;
+    }
+
+    if(fy1 < am_viewbox[BOXBOTTOM] && fy2 < am_viewbox[BOXBOTTOM]) {
+        return false;
+    }
+
+    if(fy1 > am_viewbox[BOXTOP] && fy2 > am_viewbox[BOXTOP]) {
+        return false;
+    }
+
+    return true;
+}
+
 //
 // AM_DrawMapped
 //
@@ -631,6 +704,10 @@ static void AM_DrawMapped(void) {
                         x2 = seg->linedef->v2->x;
                         y2 = seg->linedef->v2->y;
 
+                        if(!AM_LineInView(x1, y1, x2, y2)) {
+                            continue;
+                        }
+
                         AM_DrawLine(x1, x2, y1, y2, scale, WHITE);
                     }
 
@@ -669,6 +746,14 @@ static void AM_DrawNodes(void) {
         if(am_nodes.value < 4) {
             node = &nodes[i];
 
+            if(!AM_LineInView(
+                        MIN(node->bbox[0][BOXLEFT], node->bbox[1][BOXLEFT]),
+                        MIN(node->bbox[0][BOXBOTTOM], node->bbox[1][BOXBOTTOM]),
+                        MAX(node->bbox[0][BOXRIGHT], node->bbox[1][BOXRIGHT]),
+                        MAX(node->bbox[0][BOXTOP], node->bbox[1][BOXTOP]))) {
+                continue;
+            }
+
             if(am_nodes.value == 1 || am_nodes.value >= 3) {
                 x1 = node->bbox[0][BOXLEFT];
                 y1 = node->bbox[0][BOXTOP];
@@ -744,87 +829,162 @@ static void AM_DrawNodes(void) {
 }
 
 //
-// AM_DrawWalls
-// Determines visible lines, draws them.
-// This is LineDef based, not LineSeg based.
+// AUTOMAP LINE CACHE
+//
+// A linedef's automap color only changes when its flags or special
+// change, or when one of the global automap toggles is flipped, so
+// the colors are kept for the whole level and only recomputed then.
 //
 
-void AM_DrawWalls(void) {
-    int i;
-    int x1, x2, y1, y2;
+typedef struct {
+    rcolor  color;      // 0 if the line isn't drawn
+    int     flags;
+    int     special;
+    int     key;
+} amline_t;
+
+static amline_t *am_linecache = NULL;
+static int am_linekey = 0;
 
-    for(i = 0; i < numlines; i++) {
-        line_t *l;
+//
+// AM_LineColor
+//
 
-        l = &lines[i];
+static rcolor AM_LineColor(line_t *l) {
+    rcolor color;
 
-        x1 = l->v1->x;
-        y1 = l->v1->y;
-        x2 = l->v2->x;
-        y2 = l->v2->y;
+    //
+    // 20120208 villsa - re-ordered flag checks to match original game
+    //
 
-        //
-        // 20120208 villsa - re-ordered flag checks to match original game
-        //
+    if(l->flags & ML_DONTDRAW) {
+        return 0;
+    }
 
-        if(l->flags & ML_DONTDRAW) {
-            continue;
-        }
+    if(!((l->flags & ML_MAPPED) || am_fulldraw.value || plr->powers[pw_allmap] || amCheating)) {
+        return 0;
+    }
 
-        if((l->flags & ML_MAPPED) || am_fulldraw.value || plr->powers[pw_allmap] || amCheating) {
-            rcolor color = D_RGBA(0x8A, 0x5C, 0x30, 0xFF);  // default color
+    color = D_RGBA(0x8A, 0x5C, 0x30, 0xFF);  // default color
 
-            //
-            // check for cheats
-            //
-            if((plr->powers[pw_allmap] || amCheating) && !(l->flags & ML_MAPPED)) {
-                color = D_RGBA(0x80, 0x80, 0x80, 0xFF);
+    //
+    // check for cheats
+    //
+    if((plr->powers[pw_allmap] || amCheating) && !(l->flags & ML_MAPPED)) {
+        color = D_RGBA(0x80, 0x80, 0x80, 0xFF);
+    }
+    //
+    // check for secret line
+    //
+    else if(l->flags & ML_SECRET) {
+        color = D_RGBA(0xA4, 0x00, 0x00, 0xFF);
+    }
+    //
+    // handle special line
+    //
+    else if(l->special && !(l->flags & ML_HIDEAUTOMAPTRIGGER)) {
+        //
+        // draw colored doors based on key requirement
+        //
+        if(am_showkeycolors.value) {
+            if(l->special & MLU_RED) {
+                color = D_RGBA(0xFF, 0x00, 0x00, 0xFF);
             }
-            //
-            // check for secret line
-            //
-            else if(l->flags & ML_SECRET) {
-                color = D_RGBA(0xA4, 0x00, 0x00, 0xFF);
+            else if(l->special & MLU_BLUE) {
+                color = D_RGBA(0x00, 0x00, 0xFF, 0xFF);
             }
-            //
-            // handle special line
-            //
-            else if(l->special && !(l->flags & ML_HIDEAUTOMAPTRIGGER)) {
+            else if(l->special & MLU_YELLOW) {
+                color = D_RGBA(0xFF, 0xFF, 0x00, 0xFF);
+            }
+            else {
                 //
-                // draw colored doors based on key requirement
+                // change color to green to avoid confusion with yellow key doors
                 //
-                if(am_showkeycolors.value) {
-                    if(l->special & MLU_RED) {
-                        color = D_RGBA(0xFF, 0x00, 0x00, 0xFF);
-                    }
-                    else if(l->special & MLU_BLUE) {
-                        color = D_RGBA(0x00, 0x00, 0xFF, 0xFF);
-                    }
-                    else if(l->special & MLU_YELLOW) {
-                        color = D_RGBA(0xFF, 0xFF, 0x00, 0xFF);
-                    }
-                    else {
-                        //
-                        // change color to green to avoid confusion with yellow key doors
-                        //
-                        color = D_RGBA(0x00, 0xCC, 0x00, 0xFF);
-                    }
-                }
-                else {
-                    //
-                    // default color for special lines
-                    //
-                    color = D_RGBA(0xCC, 0xCC, 0x00, 0xFF);
-                }
+                color = D_RGBA(0x00, 0xCC, 0x00, 0xFF);
             }
+        }
+        else {
             //
-            // solid wall?
+            // default color for special lines
             //
-            else if(!(l->flags & ML_TWOSIDED)) {
-                color = D_RGBA(0xA4, 0x00, 0x00, 0xFF);
-            }
+            color = D_RGBA(0xCC, 0xCC, 0x00, 0xFF);
+        }
+    }
+    //
+    // solid wall?
+    //
+    else if(!(l->flags & ML_TWOSIDED)) {
+        color = D_RGBA(0xA4, 0x00, 0x00, 0xFF);
+    }
+
+    return color;
+}
 
-            AM_DrawLine(x1, x2, y1, y2, scale, color);
+//
+// PIT_DrawMapLine
+//
+
+static dboolean PIT_DrawMapLine(line_t *l) {
+    amline_t *aml = &am_linecache[l - lines];
+
+    if(aml->key != am_linekey || aml->flags != l->flags || aml->special != l->special) {
+        aml->color      = AM_LineColor(l);
+        aml->flags      = l->flags;
+        aml->special    = l->special;
+        aml->key        = am_linekey;
+    }
+
+    if(aml->color) {
+        AM_DrawLine(l->v1->x, l->v2->x, l->v1->y, l->v2->y, scale, aml->color);
+    }
+
+    return true;
+}
+
+//
+// AM_DrawWalls
+// Determines visible lines, draws them.
+// This is LineDef based, not LineSeg based.
+// Only the blockmap cells touching the view are walked.
+//
+
+void AM_DrawWalls(void) {
+    int x;
+    int y;
+    int bx1;
+    int bx2;
+    int by1;
+    int by2;
+    float orgx;
+    float orgy;
+
+    if(!am_linecache) {
+        am_linecache = Z_Malloc(numlines * sizeof(amline_t), PU_LEVEL, &am_linecache);
+        dmemset(am_linecache, 0, numlines * sizeof(amline_t));
+    }
+
+    //
+    // any change here invalidates all cached colors. never zero
+    // so freshly cleared entries are always rebuilt
+    //
+    am_linekey = 1 |
+                 ((plr->powers[pw_allmap] || amCheating) ? 2 : 0) |
+                 (am_fulldraw.value ? 4 : 0) |
+                 (am_showkeycolors.value ? 8 : 0);
+
+    orgx = F2D3D(bmaporgx);
+    orgy = F2D3D(bmaporgy);
+
+    bx1 = MAX((int)((am_viewbox[BOXLEFT] - orgx) / MAPBLOCKUNITS), 0);
+    bx2 = MIN((int)((am_viewbox[BOXRIGHT] - orgx) / MAPBLOCKUNITS), bmapwidth - 1);
+    by1 = MAX((int)((am_viewbox[BOXBOTTOM] - orgy) / MAPBLOCKUNITS), 0);
+    by2 = MIN((int)((am_viewbox[BOXTOP] - orgy) / MAPBLOCKUNITS), bmapheight - 1);
+
+    validcount++;
+
+    for(y = by1; y <= by2; y++) {
+        for(x = bx1; x <= bx2; x++) {
+            P_BlockLinesIterator(x, y, PIT_DrawMapLine);
         }
     }
 }
@@ -880,96 +1040,108 @@ void AM_drawPlayers(void) {
 // AM_drawThings
 //
 
+#define AM_THINGMARGIN  (128*FRACUNIT)   // room for the marker sprite
+
 void AM_drawThings(void) {
     int     i;
     mobj_t*    t;
 
-    for(i = 0; i < numsectors; i++) {
-        t = sectors[i].thinglist;
+    // walk the packed slot mirrors rather than every sector's
+    // thinglist, so culled things are never dereferenced
+    for(i = 0; i < nummobjslots; i++) {
+        if(mobjslotsub[i] < 0) {
+            continue;
+        }
 
-        while(t) {
-            //
-            // draw thing triangles for automap cheat
-            //
-            if(amCheating == 2) {
-                if(t->type != MT_PLAYER && am_drawobjects.value != 1) {
-                    //
-                    // shootable stuff are marked as red while normal things are blue
-                    //
-                    if(t->flags & MF_SHOOTABLE || t->flags & MF_MISSILE) {
-                        AM_DrawTriangle(t, scale, amModeCycle, 164, 0, 0);
-                    }
-                    else {
-                        AM_DrawTriangle(t, scale, amModeCycle, 51, 115, 179);
-                    }
-                }
+        //
+        // skip things that are nowhere near the view
+        //
+        if(!AM_LineInView(mobjslotx[i] - AM_THINGMARGIN, mobjsloty[i] - AM_THINGMARGIN,
+                          mobjslotx[i] + AM_THINGMARGIN, mobjsloty[i] + AM_THINGMARGIN)) {
+            continue;
+        }
 
-                if(am_drawobjects.value) {
-                    AM_DrawSprite(t, scale);
+        t = mobjslotmobj[i];
+
+        //
+        // draw thing triangles for automap cheat
+        //
+        if(amCheating == 2) {
+            if(t->type != MT_PLAYER && am_drawobjects.value != 1) {
+                //
+                // shootable stuff are marked as red while normal things are blue
+                //
+                if(t->flags & MF_SHOOTABLE || t->flags & MF_MISSILE) {
+                    AM_DrawTriangle(t, scale, amModeCycle, 164, 0, 0);
+                }
+                else {
+                    AM_DrawTriangle(t, scale, amModeCycle, 51, 115, 179);
                 }
             }
-            //
-            // draw colored keys and artifacts in automap for new players
-            //
-            else if(am_showkeymarkers.value) {
-                if(t->type >= MT_ITEM_BLUECARDKEY && t->type <= MT_ITEM_ARTIFACT3) {
-                    byte r, g, b;
-
-                    switch(t->type) {
-                    case MT_ITEM_BLUECARDKEY:
-                    case MT_ITEM_BLUESKULLKEY:
-                        r = 0;
-                        g = 64;
-                        b = 255;
-                        break;
-
-                    case MT_ITEM_REDCARDKEY:
-                    case MT_ITEM_REDSKULLKEY:
-                        r = 255;
-                        g = 0;
-                        b = 0;
-                        break;
-
-                    case MT_ITEM_YELLOWCARDKEY:
-                    case MT_ITEM_YELLOWSKULLKEY:
-                        r = 255;
-                        g = 128;
-                        b = 0;
-                        break;
-
-                    case MT_ITEM_ARTIFACT1:
-                        r = 224;
-                        g = 56;
-                        b = 0;
-                        break;
-
-                    case MT_ITEM_ARTIFACT2:
-                        r = 0;
-                        g = 200;
-                        b = 224;
-                        break;
-
-                    case MT_ITEM_ARTIFACT3:
-                        r = 120;
-                        g = 0;
-                        b = 224;
-                        break;
-                    default:
-                        r = g = b = 255;
-                        break;
-                    }
 
-                    if(am_drawobjects.value != 1) {
-                        AM_DrawTriangle(t, scale, amModeCycle, r, g, b);
-                    }
+            if(am_drawobjects.value) {
+                AM_DrawSprite(t, scale);
+            }
+        }
+        //
+        // draw colored keys and artifacts in automap for new players
+        //
+        else if(am_showkeymarkers.value) {
+            if(t->type >= MT_ITEM_BLUECARDKEY && t->type <= MT_ITEM_ARTIFACT3) {
+                byte r, g, b;
+
+                switch(t->type) {
+                case MT_ITEM_BLUECARDKEY:
+                case MT_ITEM_BLUESKULLKEY:
+                    r = 0;
+                    g = 64;
+                    b = 255;
+                    break;
 
-                    if(am_drawobjects.value) {
-                        AM_DrawSprite(t, scale);
-                    }
+                case MT_ITEM_REDCARDKEY:
+                case MT_ITEM_REDSKULLKEY:
+                    r = 255;
+                    g = 0;
+                    b = 0;
+                    break;
+
+                case MT_ITEM_YELLOWCARDKEY:
+                case MT_ITEM_YELLOWSKULLKEY:
+                    r = 255;
+                    g = 128;
+                    b = 0;
+                    break;
+
+                case MT_ITEM_ARTIFACT1:
+                    r = 224;
+                    g = 56;
+                    b = 0;
+                    break;
+
+                case MT_ITEM_ARTIFACT2:
+                    r = 0;
+                    g = 200;
+                    b = 224;
+                    break;
+
+                case MT_ITEM_ARTIFACT3:
+                    r = 120;
+                    g = 0;
+                    b = 224;
+                    break;
+                default:
+                    r = g = b = 255;
+                    break;
+                }
+
+                if(am_drawobjects.value != 1) {
+                    AM_DrawTriangle(t, scale, amModeCycle, r, g, b);
                 }
-            }
 
-            t = t->snext;
+                if(am_drawobjects.value) {
+                    AM_DrawSprite(t, scale);
+                }
+            }
         }
     }
 }
@@ -1006,6 +1178,7 @@ void AM_Drawer(void) {
     }
 
     AM_BeginDraw(view, x, y);
+    AM_GetViewBox(x, y, view);
 
     if(!amModeCycle) {
         AM_DrawMapped();
@@ -1020,6 +1193,8 @@ void AM_Drawer(void) {
         AM_DrawNodes();
     }
 
+    AM_FlushLines();
+
     AM_drawPlayers();
 
     if(amCheating == 2 || am_showkeymarkers.value) {
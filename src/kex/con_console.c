@@ -516,6 +516,8 @@ void CON_Draw(void) {
 
     y = CONSOLE_Y - 2;
 
+    Draw_BeginBatch();
+
     if(line < MAX_CONSOLE_LINES) {
         while(console_buffer[line] && y > 0) {
             Draw_ConsoleText(0, y, console_buffer[line]->color, CONFONT_SCALE, "%s", console_buffer[line]->line);
@@ -531,4 +533,6 @@ void CON_Draw(void) {
 
     inputlen = Draw_ConsoleText(x, y, WHITE, CONFONT_SCALE, "%s", console_inputbuffer);
     Draw_ConsoleText(x + inputlen, y, WHITE, CONFONT_SCALE, "_");
+
+    Draw_EndBatch();
 }
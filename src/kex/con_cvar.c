@@ -39,6 +39,7 @@
 #include "st_stuff.h"
 #include "g_game.h"
 #include "g_actions.h"
+#include "d_trace.h"
 
 cvar_t  *cvarcap;
 
@@ -229,6 +230,7 @@ void CON_CvarInit(void) {
     M_RegisterCvars();
     P_RegisterCvars();
     G_RegisterCvars();
+    D_RegisterTraceCvars();
 
     G_AddCommand("listcvars", CMD_ListCvars, 0);
 }
@@ -40,7 +40,7 @@
 
 static dboolean showstats = true;
 
-extern word statindice;
+extern dword statindice;
 
 CVAR_EXTERNAL(v_mlook);
 CVAR_EXTERNAL(v_mlookinvert);
@@ -86,16 +86,20 @@ void D_DeveloperDisplay(void) {
     int p_nummobjthinkers = 0;
     fixed_t px, py, pz, pa, pp;
     int y = 8;
+    int sightchecks;
     mobj_t* mo;
 
     if(!showstats) {
         glBindCalls = 0;
+        glDrawCalls = 0;
         vertCount = 0;
         statindice = 0;
 
         return;
     }
 
+    Draw_BeginBatch();
+
     /*PLAYER INFORMATION*/
 
     px=py=pz=pa=pp=0;
@@ -158,6 +162,17 @@ void D_DeveloperDisplay(void) {
 
         Draw_Text(0, y, WHITE, 0.35f, false, "P_Mobj Total Things: %i", p_nummobjthinkers);
         y+=16;
+
+        sightchecks = sightcachecounts[0] + sightcachecounts[1];
+        Draw_Text(0, y, WHITE, 0.35f, false, "Sight Cache Hits: %i/%i (%i%%)",
+                  sightcachecounts[0], sightchecks,
+                  sightchecks ? (sightcachecounts[0] * 100) / sightchecks : 0);
+        y+=16;
+
+        if(gameflags & GF_DORMANTMONSTERS) {
+            Draw_Text(0, y, WHITE, 0.35f, false, "Dormant Mobjs: %i", numdormantmobjs);
+            y+=16;
+        }
     }
 
     /*RENDERING INFORMATION*/
@@ -177,6 +192,9 @@ void D_DeveloperDisplay(void) {
     Draw_Text(0, y, WHITE, 0.35f, false, "Draw Indices: %i", statindice);
     y+=16;
 
+    Draw_Text(0, y, WHITE, 0.35f, false, "Draw Calls: %i", glDrawCalls);
+    y+=16;
+
     if(gamestate == GS_LEVEL && !automapactive) {
         Draw_Text(0, y, WHITE, 0.35f, false, "PlayerView Render Time: %ims", renderTic);
         y+=16;
@@ -195,7 +213,10 @@ void D_DeveloperDisplay(void) {
     Z_PrintStats();
 #endif
 
+    Draw_EndBatch();
+
     glBindCalls = 0;
+    glDrawCalls = 0;
     vertCount = 0;
     statindice = 0;
 }
@@ -64,6 +64,9 @@
 #include "g_demo.h"
 #include "p_saveg.h"
 #include "gl_draw.h"
+#include "d_trace.h"
+#include "p_tick.h"
+#include "p_local.h"
 
 #include "Ext/ChocolateDoom/net_client.h"
 
@@ -90,6 +93,7 @@ dboolean        setWindow       = true;
 int             validcount      = 1;
 dboolean        windowpause     = false;
 dboolean        devparm         = false;    // started game with -devparm
+dboolean        nodrawparm      = false;    // started game with -nodraw/-headless
 dboolean        nomonsters      = false;    // checkparm of -nomonsters
 dboolean        respawnparm     = false;    // checkparm of -respawn
 dboolean        respawnitem     = false;    // checkparm of -respawnitem
@@ -119,6 +123,7 @@ CVAR_EXTERNAL(sv_fastmonsters);
 CVAR_EXTERNAL(sv_respawnitems);
 CVAR_EXTERNAL(sv_respawn);
 CVAR_EXTERNAL(sv_skill);
+CVAR_EXTERNAL(p_sightthreads);
 
 
 //
@@ -234,6 +239,53 @@ static void D_FinishDraw(void) {
     }
 }
 
+//
+// HEADLESS MODE
+// -nodraw/-headless runs the playsim as fast as it can with no
+// video, audio or input, then reports the tic rate and a hash
+// of the final world state
+//
+
+#define HEADLESS_DEFAULTTICS    (TICRATE * 60 * 10)
+
+static int      headlesstics = 0;
+static int      headlessmaxtics = 0;
+static uint64   headlessstarttime = 0;
+
+//
+// D_HeadlessReport
+//
+
+void D_HeadlessReport(void) {
+    float total;
+    float rate;
+
+    total = (float)(I_GetTimeUS() - headlessstarttime) / 1000000.0f;
+    rate = total > 0 ? (float)headlesstics / total : 0;
+
+    I_Printf("--------Headless run--------\n");
+    I_Printf("ran %i gametics in %.3f s: %.1f tics/sec\n", headlesstics, total, rate);
+    I_Printf("map %i, leveltime %i, state hash %08x\n", gamemap, leveltime, P_WorldHash());
+
+    if(sightcheck) {
+        I_Printf("sight check: %i of %i parallel results differ\n",
+                 sightcheckcounts[1], sightcheckcounts[0]);
+    }
+}
+
+//
+// D_HeadlessTic
+//
+
+static void D_HeadlessTic(void) {
+    headlesstics++;
+
+    if(headlessmaxtics && headlesstics >= headlessmaxtics) {
+        D_HeadlessReport();
+        I_Quit();
+    }
+}
+
 int D_MiniLoop(void (*start)(void), void (*stop)(void),
                void (*draw)(void), dboolean(*tick)(void)) {
     int action = gameaction = ga_nothing;
@@ -251,8 +303,44 @@ int D_MiniLoop(void (*start)(void), void (*stop)(void),
         int availabletics = 0;
         int counts = 0;
 
+        TRACE_BEGIN("D_MiniLoop");
+
         windowpause = (menuactive ? true : false);
 
+        // timedemo runs exactly one tic per frame regardless of the
+        // wall clock so every run of a demo renders the same frames.
+        // headless mode runs tics the same way but never draws
+        if(timingdemo || nodrawparm) {
+            if(!nodrawparm) {
+                I_StartTic();
+                D_ProcessEvents();
+            }
+
+            maketic = gametic/ticdup + 1;
+            nettics[consoleplayer] = maketic;
+
+            G_Ticker();
+
+            if(tick) {
+                action = tick();
+            }
+
+            if(gameaction != ga_nothing) {
+                action = gameaction;
+            }
+
+            gametic++;
+
+            if(nodrawparm) {
+                D_HeadlessTic();
+                goto freealloc;
+            }
+
+            rendertic_frac = FRACUNIT;
+
+            goto drawframe;
+        }
+
         // process one or more tics
 
         // get real tics
@@ -433,7 +521,7 @@ drawframe:
         S_UpdateSounds();
 
         // Update display, next frame, with current state.
-        if(i_interpolateframes.value) {
+        if(i_interpolateframes.value && !timingdemo) {
             if(!I_StartDisplay()) {
                 goto freealloc;
             }
@@ -442,6 +530,11 @@ drawframe:
         if(draw && !action) {
             draw();
         }
+
+        if(timingdemo) {
+            G_TimeDemoFrame();
+        }
+
         D_DrawInterface();
         D_FinishDraw();
 
@@ -449,6 +542,8 @@ freealloc:
 
         // force garbage collection
         Z_FreeAlloca();
+
+        TRACE_END();
     }
 
     gamestate = GS_NONE;
@@ -953,10 +1048,25 @@ static int D_CheckDemo(void) {
     p = M_CheckParm("-playdemo");
     if(p && p < myargc-1) {
         //singledemo = true;              // quit after one demo
+        singledemo = nodrawparm;
         G_PlayDemo(myargv[p+1]);
         return 1;
     }
 
+    p = M_CheckParm("-timedemo");
+    if(p && p < myargc-1) {
+        // nothing is rendered when headless, so there
+        // are no frames to time; just play it back
+        if(nodrawparm) {
+            singledemo = true;
+            G_PlayDemo(myargv[p+1]);
+        }
+        else {
+            G_TimeDemo(myargv[p+1]);
+        }
+        return 1;
+    }
+
     return 0;
 }
 
@@ -965,7 +1075,10 @@ static int D_CheckDemo(void) {
 //
 
 void D_DoomMain(void) {
+    int p;
+
     devparm = M_CheckParm("-devparm");
+    nodrawparm = (M_CheckParm("-nodraw") || M_CheckParm("-headless"));
 
     // init subsystems
 
@@ -1011,8 +1124,10 @@ void D_DoomMain(void) {
     I_Printf("ST_Init: Init status bar.\n");
     ST_Init();
 
-    I_Printf("GL_Init: Init OpenGL\n");
-    GL_Init();
+    if(!nodrawparm) {
+        I_Printf("GL_Init: Init OpenGL\n");
+        GL_Init();
+    }
 
 #ifdef USESYSCONSOLE
     I_ShowSysConsole(false);
@@ -1021,6 +1136,32 @@ void D_DoomMain(void) {
     // garbage collection
     Z_FreeAlloca();
 
+    if(nodrawparm) {
+        if(!M_CheckParm("-playdemo") && !M_CheckParm("-timedemo") && !autostart) {
+            I_Error("D_DoomMain: -nodraw needs -playdemo, -timedemo or -warp");
+        }
+
+        p = M_CheckParm("-maxtics");
+        if(p && p < myargc-1) {
+            headlessmaxtics = datoi(myargv[p+1]);
+        }
+        else if(autostart) {
+            headlessmaxtics = HEADLESS_DEFAULTTICS;
+        }
+
+        // lets a demo be replayed with the parallel sight scan and the
+        // reported hash compared against a serial run
+        p = M_CheckParm("-sightthreads");
+        if(p && p < myargc-1) {
+            CON_CvarSetValue(p_sightthreads.name, (float)datoi(myargv[p+1]));
+        }
+
+        // retrace every parallel sight result on the main thread
+        sightcheck = (M_CheckParm("-checksights") != 0);
+
+        headlessstarttime = I_GetTimeUS();
+    }
+
     if(!D_CheckDemo()) {
         if(!autostart) {
             // start legal screen and title map stuff
@@ -1031,5 +1172,11 @@ void D_DoomMain(void) {
         }
     }
 
+    // headless session ended without hitting the tic limit
+    if(nodrawparm) {
+        D_HeadlessReport();
+        I_Quit();
+    }
+
     D_DoomLoop();   // never returns
 }
@@ -53,6 +53,8 @@ void D_PostEvent(event_t* ev);
 
 void D_IncValidCount(void);
 
+void D_HeadlessReport(void);
+
 extern dboolean BusyDisk;
 
 #endif
@@ -38,6 +38,7 @@
 #include "con_console.h"
 #include "SDL.h"
 #include "i_video.h"
+#include "d_trace.h"
 
 #define FEATURE_MULTIPLAYER 1
 
@@ -115,6 +116,8 @@ void NetUpdate(void) {
         return;
     }
 
+    TRACE_BEGIN("NetUpdate");
+
 #ifdef FEATURE_MULTIPLAYER
 
     // Run network subsystems
@@ -187,6 +190,8 @@ void NetUpdate(void) {
         ++maketic;
         nettics[consoleplayer] = maketic;
     }
+
+    TRACE_END();
 }
 
 //
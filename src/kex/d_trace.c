@@ -0,0 +1,211 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2012 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION: Frame tracer
+//
+// Named spans are timed with a nanosecond clock and stored into a
+// ring buffer while d_trace is enabled. The tracedump command writes
+// the buffer out as a Chrome trace (chrome://tracing or Perfetto).
+//
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+
+#include "doomdef.h"
+#include "doomstat.h"
+#include "i_system.h"
+#include "z_zone.h"
+#include "con_console.h"
+#include "con_cvar.h"
+#include "g_actions.h"
+#include "d_trace.h"
+
+CVAR(d_trace, 0);
+
+#ifdef USE_TRACE
+
+#define MAXTRACESPANS   0x10000     // must be a power of two
+#define MAXTRACEDEPTH   32
+
+typedef struct {
+    const char  *name;
+    uint64      start;
+    uint64      end;
+    int         depth;
+} tracespan_t;
+
+static tracespan_t  *tracespans = NULL;
+static int          tracehead = 0;
+static int          tracecount = 0;
+static dboolean     tracing = false;
+static int          tracedepth = 0;
+static const char   *tracestack_name[MAXTRACEDEPTH];
+static uint64       tracestack_start[MAXTRACEDEPTH];
+
+//
+// D_TraceBegin
+//
+
+void D_TraceBegin(const char* name) {
+    //
+    // only pick up changes to d_trace between outermost spans
+    // so begin and end calls always pair up
+    //
+    if(tracedepth == 0) {
+        tracing = (d_trace.value > 0);
+
+        if(tracing && !tracespans) {
+            tracespans = Z_Malloc(MAXTRACESPANS * sizeof(tracespan_t), PU_STATIC, 0);
+        }
+    }
+
+    if(!tracing) {
+        return;
+    }
+
+    if(tracedepth < MAXTRACEDEPTH) {
+        tracestack_name[tracedepth] = name;
+        tracestack_start[tracedepth] = I_GetTimeNS();
+    }
+
+    tracedepth++;
+}
+
+//
+// D_TraceEnd
+//
+
+void D_TraceEnd(void) {
+    tracespan_t *span;
+
+    if(!tracing || tracedepth <= 0) {
+        return;
+    }
+
+    tracedepth--;
+
+    if(tracedepth >= MAXTRACEDEPTH) {
+        return;
+    }
+
+    span = &tracespans[tracehead];
+    span->name  = tracestack_name[tracedepth];
+    span->start = tracestack_start[tracedepth];
+    span->end   = I_GetTimeNS();
+    span->depth = tracedepth;
+
+    tracehead = (tracehead + 1) & (MAXTRACESPANS - 1);
+
+    if(tracecount < MAXTRACESPANS) {
+        tracecount++;
+    }
+}
+
+//
+// CMD_TraceDump
+//
+
+static CMD(TraceDump) {
+    FILE *f;
+    const char *name = "trace.json";
+    int first;
+    int i;
+
+    if(param[0]) {
+        name = param[0];
+    }
+
+    if(!tracecount) {
+        CON_Printf(WHITE, "No spans recorded, set d_trace to 1 first\n");
+        return;
+    }
+
+    f = fopen(name, "w");
+
+    if(!f) {
+        CON_Warnf("Couldn't write %s\n", name);
+        return;
+    }
+
+    first = (tracehead - tracecount) & (MAXTRACESPANS - 1);
+
+    fprintf(f, "{\"traceEvents\":[\n");
+
+    for(i = 0; i < tracecount; i++) {
+        tracespan_t *span = &tracespans[(first + i) & (MAXTRACESPANS - 1)];
+
+        //
+        // timestamps are in microseconds, keep the fraction
+        //
+        fprintf(f, "{\"name\":\"%s\",\"cat\":\"doom64ex\",\"ph\":\"X\","
+                "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1,"
+                "\"args\":{\"depth\":%i}}%s\n",
+                span->name,
+                (double)span->start / 1000.0,
+                (double)(span->end - span->start) / 1000.0,
+                span->depth,
+                i == tracecount - 1 ? "" : ",");
+    }
+
+    fprintf(f, "],\"displayTimeUnit\":\"ns\"}\n");
+    fclose(f);
+
+    CON_Printf(WHITE, "Wrote %i spans to %s\n", tracecount, name);
+}
+
+//
+// CMD_TraceClear
+//
+
+static CMD(TraceClear) {
+    tracehead = 0;
+    tracecount = 0;
+}
+
+#else
+
+//
+// CMD_TraceDump
+//
+
+static CMD(TraceDump) {
+    CON_Printf(WHITE, "Tracing was compiled out (USE_TRACE)\n");
+}
+
+//
+// CMD_TraceClear
+//
+
+static CMD(TraceClear) {
+}
+
+#endif
+
+//
+// D_RegisterTraceCvars
+//
+
+void D_RegisterTraceCvars(void) {
+    CON_CvarRegister(&d_trace);
+    G_AddCommand("tracedump", CMD_TraceDump, 0);
+    G_AddCommand("traceclear", CMD_TraceClear, 0);
+}
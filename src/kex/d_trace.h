@@ -0,0 +1,48 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2012 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef __D_TRACE_H__
+#define __D_TRACE_H__
+
+//
+// comment this out to compile every trace point out of the game
+//
+#define USE_TRACE
+
+void D_RegisterTraceCvars(void);
+
+#ifdef USE_TRACE
+
+void D_TraceBegin(const char* name);
+void D_TraceEnd(void);
+
+#define TRACE_BEGIN(name)   D_TraceBegin(name)
+#define TRACE_END()         D_TraceEnd()
+
+#else
+
+#define TRACE_BEGIN(name)
+#define TRACE_END()
+
+#endif
+
+#endif
@@ -31,13 +31,22 @@
 #include "gl_texture.h"
 #include "con_console.h"
 #include "i_system.h"
+#include "r_main.h"
+#include "z_zone.h"
 
-#define MAXINDICES  0x10000
+#define INITINDICES 0x10000
 
-word statindice = 0;
+dword statindice = 0;
 
-static word indicecnt = 0;
-static word drawIndices[MAXINDICES];
+//
+// index storage grows on demand. indices are 16-bit unless a
+// triangle references a vertex past 0xffff, in which case the
+// buffer is widened to 32-bit for the rest of the current batch
+//
+static dword indicecnt = 0;
+static dword indicemax = 0;
+static dboolean indicelarge = false;
+static void *drawIndices = NULL;
 
 CVAR_EXTERNAL(r_drawtris);
 
@@ -105,6 +114,34 @@ d_inline void dglSetVertex(vtx_t *vtx) {
     dgl_prevptr = vtx;
 }
 
+//
+// dglGrowIndices
+//
+
+static void dglGrowIndices(void) {
+    indicemax = indicemax ? indicemax * 2 : INITINDICES;
+
+    // always sized for 32-bit so widening never needs to reallocate
+    drawIndices = Z_Realloc(drawIndices, indicemax * sizeof(dword), PU_STATIC, 0);
+}
+
+//
+// dglWidenIndices
+//
+
+static void dglWidenIndices(void) {
+    word *src = (word*)drawIndices;
+    dword *dst = (dword*)drawIndices;
+    int i;
+
+    // walk backwards so entries aren't overwritten before they're read
+    for(i = (int)indicecnt - 1; i >= 0; i--) {
+        dst[i] = src[i];
+    }
+
+    indicelarge = true;
+}
+
 //
 // dglTriangle
 //
@@ -113,13 +150,30 @@ d_inline void dglTriangle(int v0, int v1, int v2) {
 #ifdef LOG_GLFUNC_CALLS
     I_Printf("dglTriangle(v0=%i, v1=%i, v2=%i)\n", v0, v1, v2);
 #endif
-    if(indicecnt + 3 >= MAXINDICES) {
-        I_Error("Triangle indice overflow");
+    if(indicecnt + 3 > indicemax) {
+        dglGrowIndices();
+    }
+
+    if(!indicelarge && (v0 | v1 | v2) > 0xffff) {
+        dglWidenIndices();
     }
 
-    drawIndices[indicecnt++] = v0;
-    drawIndices[indicecnt++] = v1;
-    drawIndices[indicecnt++] = v2;
+    if(indicelarge) {
+        dword *idx = (dword*)drawIndices + indicecnt;
+
+        idx[0] = v0;
+        idx[1] = v1;
+        idx[2] = v2;
+    }
+    else {
+        word *idx = (word*)drawIndices + indicecnt;
+
+        idx[0] = v0;
+        idx[1] = v1;
+        idx[2] = v2;
+    }
+
+    indicecnt += 3;
 }
 
 //
@@ -135,22 +189,20 @@ d_inline void dglDrawGeometry(dword count, vtx_t *vtx) {
         dglLockArraysEXT(0, count);
     }
 
-    dglDrawElements(GL_TRIANGLES, indicecnt, GL_UNSIGNED_SHORT, drawIndices);
+    dglDrawElements(GL_TRIANGLES, indicecnt,
+                    indicelarge ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT, drawIndices);
 
     if(has_GL_EXT_compiled_vertex_array) {
         dglUnlockArraysEXT();
     }
 
     if(r_drawtris.value) {
-        dword j = 0;
         byte b;
 
-        for(j = 0; j < count; j++) {
-            vtx[j].r = 0xff;
-            vtx[j].g = 0xff;
-            vtx[j].b = 0xff;
-            vtx[j].a = 0xff;
-        }
+        // draw the lines in white without touching the caller's
+        // colors; some vertex lists (the sky dome) are cached
+        dglDisableClientState(GL_COLOR_ARRAY);
+        dglColor4ub(0xff, 0xff, 0xff, 0xff);
 
         dglGetBooleanv(GL_FOG, &b);
 
@@ -167,7 +219,8 @@ d_inline void dglDrawGeometry(dword count, vtx_t *vtx) {
             dglLockArraysEXT(0, count);
         }
 
-        dglDrawElements(GL_TRIANGLES, indicecnt, GL_UNSIGNED_SHORT, drawIndices);
+        dglDrawElements(GL_TRIANGLES, indicecnt,
+                    indicelarge ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT, drawIndices);
 
         if(has_GL_EXT_compiled_vertex_array) {
             dglUnlockArraysEXT();
@@ -176,6 +229,7 @@ d_inline void dglDrawGeometry(dword count, vtx_t *vtx) {
         dglDepthRange(0.0f, 1.0f);
         dglPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
         dglEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        dglEnableClientState(GL_COLOR_ARRAY);
         dglEnable(GL_TEXTURE_2D);
 
         if(b) {
@@ -183,11 +237,13 @@ d_inline void dglDrawGeometry(dword count, vtx_t *vtx) {
         }
     }
 
-    if(devparm) {
+    if(devparm || timingdemo) {
         statindice += indicecnt;
+        glDrawCalls++;
     }
 
     indicecnt = 0;
+    indicelarge = false;
 }
 
 //
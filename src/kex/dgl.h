@@ -4267,5 +4267,604 @@ dboolean has_GL_EXT_texture_filter_anisotropic = false;
 #define GL_EXT_texture_filter_anisotropic_Init() \
 has_GL_EXT_texture_filter_anisotropic = GL_CheckExtension("GL_EXT_texture_filter_anisotropic");
 
+//
+// GL_ARB_shader_objects
+//
+extern dboolean has_GL_ARB_shader_objects;
+
+extern PFNGLDELETEOBJECTARBPROC _glDeleteObjectARB;
+extern PFNGLGETHANDLEARBPROC _glGetHandleARB;
+extern PFNGLDETACHOBJECTARBPROC _glDetachObjectARB;
+extern PFNGLCREATESHADEROBJECTARBPROC _glCreateShaderObjectARB;
+extern PFNGLSHADERSOURCEARBPROC _glShaderSourceARB;
+extern PFNGLCOMPILESHADERARBPROC _glCompileShaderARB;
+extern PFNGLCREATEPROGRAMOBJECTARBPROC _glCreateProgramObjectARB;
+extern PFNGLATTACHOBJECTARBPROC _glAttachObjectARB;
+extern PFNGLLINKPROGRAMARBPROC _glLinkProgramARB;
+extern PFNGLUSEPROGRAMOBJECTARBPROC _glUseProgramObjectARB;
+extern PFNGLVALIDATEPROGRAMARBPROC _glValidateProgramARB;
+extern PFNGLUNIFORM1FARBPROC _glUniform1fARB;
+extern PFNGLUNIFORM2FARBPROC _glUniform2fARB;
+extern PFNGLUNIFORM3FARBPROC _glUniform3fARB;
+extern PFNGLUNIFORM4FARBPROC _glUniform4fARB;
+extern PFNGLUNIFORM1IARBPROC _glUniform1iARB;
+extern PFNGLUNIFORM2IARBPROC _glUniform2iARB;
+extern PFNGLUNIFORM3IARBPROC _glUniform3iARB;
+extern PFNGLUNIFORM4IARBPROC _glUniform4iARB;
+extern PFNGLUNIFORM1FVARBPROC _glUniform1fvARB;
+extern PFNGLUNIFORM2FVARBPROC _glUniform2fvARB;
+extern PFNGLUNIFORM3FVARBPROC _glUniform3fvARB;
+extern PFNGLUNIFORM4FVARBPROC _glUniform4fvARB;
+extern PFNGLUNIFORM1IVARBPROC _glUniform1ivARB;
+extern PFNGLUNIFORM2IVARBPROC _glUniform2ivARB;
+extern PFNGLUNIFORM3IVARBPROC _glUniform3ivARB;
+extern PFNGLUNIFORM4IVARBPROC _glUniform4ivARB;
+extern PFNGLUNIFORMMATRIX2FVARBPROC _glUniformMatrix2fvARB;
+extern PFNGLUNIFORMMATRIX3FVARBPROC _glUniformMatrix3fvARB;
+extern PFNGLUNIFORMMATRIX4FVARBPROC _glUniformMatrix4fvARB;
+extern PFNGLGETOBJECTPARAMETERFVARBPROC _glGetObjectParameterfvARB;
+extern PFNGLGETOBJECTPARAMETERIVARBPROC _glGetObjectParameterivARB;
+extern PFNGLGETINFOLOGARBPROC _glGetInfoLogARB;
+extern PFNGLGETATTACHEDOBJECTSARBPROC _glGetAttachedObjectsARB;
+extern PFNGLGETUNIFORMLOCATIONARBPROC _glGetUniformLocationARB;
+extern PFNGLGETACTIVEUNIFORMARBPROC _glGetActiveUniformARB;
+extern PFNGLGETUNIFORMFVARBPROC _glGetUniformfvARB;
+extern PFNGLGETUNIFORMIVARBPROC _glGetUniformivARB;
+extern PFNGLGETSHADERSOURCEARBPROC _glGetShaderSourceARB;
+
+#define GL_ARB_shader_objects_Define() \
+dboolean has_GL_ARB_shader_objects = false; \
+PFNGLDELETEOBJECTARBPROC _glDeleteObjectARB = NULL; \
+PFNGLGETHANDLEARBPROC _glGetHandleARB = NULL; \
+PFNGLDETACHOBJECTARBPROC _glDetachObjectARB = NULL; \
+PFNGLCREATESHADEROBJECTARBPROC _glCreateShaderObjectARB = NULL; \
+PFNGLSHADERSOURCEARBPROC _glShaderSourceARB = NULL; \
+PFNGLCOMPILESHADERARBPROC _glCompileShaderARB = NULL; \
+PFNGLCREATEPROGRAMOBJECTARBPROC _glCreateProgramObjectARB = NULL; \
+PFNGLATTACHOBJECTARBPROC _glAttachObjectARB = NULL; \
+PFNGLLINKPROGRAMARBPROC _glLinkProgramARB = NULL; \
+PFNGLUSEPROGRAMOBJECTARBPROC _glUseProgramObjectARB = NULL; \
+PFNGLVALIDATEPROGRAMARBPROC _glValidateProgramARB = NULL; \
+PFNGLUNIFORM1FARBPROC _glUniform1fARB = NULL; \
+PFNGLUNIFORM2FARBPROC _glUniform2fARB = NULL; \
+PFNGLUNIFORM3FARBPROC _glUniform3fARB = NULL; \
+PFNGLUNIFORM4FARBPROC _glUniform4fARB = NULL; \
+PFNGLUNIFORM1IARBPROC _glUniform1iARB = NULL; \
+PFNGLUNIFORM2IARBPROC _glUniform2iARB = NULL; \
+PFNGLUNIFORM3IARBPROC _glUniform3iARB = NULL; \
+PFNGLUNIFORM4IARBPROC _glUniform4iARB = NULL; \
+PFNGLUNIFORM1FVARBPROC _glUniform1fvARB = NULL; \
+PFNGLUNIFORM2FVARBPROC _glUniform2fvARB = NULL; \
+PFNGLUNIFORM3FVARBPROC _glUniform3fvARB = NULL; \
+PFNGLUNIFORM4FVARBPROC _glUniform4fvARB = NULL; \
+PFNGLUNIFORM1IVARBPROC _glUniform1ivARB = NULL; \
+PFNGLUNIFORM2IVARBPROC _glUniform2ivARB = NULL; \
+PFNGLUNIFORM3IVARBPROC _glUniform3ivARB = NULL; \
+PFNGLUNIFORM4IVARBPROC _glUniform4ivARB = NULL; \
+PFNGLUNIFORMMATRIX2FVARBPROC _glUniformMatrix2fvARB = NULL; \
+PFNGLUNIFORMMATRIX3FVARBPROC _glUniformMatrix3fvARB = NULL; \
+PFNGLUNIFORMMATRIX4FVARBPROC _glUniformMatrix4fvARB = NULL; \
+PFNGLGETOBJECTPARAMETERFVARBPROC _glGetObjectParameterfvARB = NULL; \
+PFNGLGETOBJECTPARAMETERIVARBPROC _glGetObjectParameterivARB = NULL; \
+PFNGLGETINFOLOGARBPROC _glGetInfoLogARB = NULL; \
+PFNGLGETATTACHEDOBJECTSARBPROC _glGetAttachedObjectsARB = NULL; \
+PFNGLGETUNIFORMLOCATIONARBPROC _glGetUniformLocationARB = NULL; \
+PFNGLGETACTIVEUNIFORMARBPROC _glGetActiveUniformARB = NULL; \
+PFNGLGETUNIFORMFVARBPROC _glGetUniformfvARB = NULL; \
+PFNGLGETUNIFORMIVARBPROC _glGetUniformivARB = NULL; \
+PFNGLGETSHADERSOURCEARBPROC _glGetShaderSourceARB = NULL
+
+#define GL_ARB_shader_objects_Init() \
+has_GL_ARB_shader_objects = GL_CheckExtension("GL_ARB_shader_objects"); \
+_glDeleteObjectARB = GL_RegisterProc("glDeleteObjectARB"); \
+_glGetHandleARB = GL_RegisterProc("glGetHandleARB"); \
+_glDetachObjectARB = GL_RegisterProc("glDetachObjectARB"); \
+_glCreateShaderObjectARB = GL_RegisterProc("glCreateShaderObjectARB"); \
+_glShaderSourceARB = GL_RegisterProc("glShaderSourceARB"); \
+_glCompileShaderARB = GL_RegisterProc("glCompileShaderARB"); \
+_glCreateProgramObjectARB = GL_RegisterProc("glCreateProgramObjectARB"); \
+_glAttachObjectARB = GL_RegisterProc("glAttachObjectARB"); \
+_glLinkProgramARB = GL_RegisterProc("glLinkProgramARB"); \
+_glUseProgramObjectARB = GL_RegisterProc("glUseProgramObjectARB"); \
+_glValidateProgramARB = GL_RegisterProc("glValidateProgramARB"); \
+_glUniform1fARB = GL_RegisterProc("glUniform1fARB"); \
+_glUniform2fARB = GL_RegisterProc("glUniform2fARB"); \
+_glUniform3fARB = GL_RegisterProc("glUniform3fARB"); \
+_glUniform4fARB = GL_RegisterProc("glUniform4fARB"); \
+_glUniform1iARB = GL_RegisterProc("glUniform1iARB"); \
+_glUniform2iARB = GL_RegisterProc("glUniform2iARB"); \
+_glUniform3iARB = GL_RegisterProc("glUniform3iARB"); \
+_glUniform4iARB = GL_RegisterProc("glUniform4iARB"); \
+_glUniform1fvARB = GL_RegisterProc("glUniform1fvARB"); \
+_glUniform2fvARB = GL_RegisterProc("glUniform2fvARB"); \
+_glUniform3fvARB = GL_RegisterProc("glUniform3fvARB"); \
+_glUniform4fvARB = GL_RegisterProc("glUniform4fvARB"); \
+_glUniform1ivARB = GL_RegisterProc("glUniform1ivARB"); \
+_glUniform2ivARB = GL_RegisterProc("glUniform2ivARB"); \
+_glUniform3ivARB = GL_RegisterProc("glUniform3ivARB"); \
+_glUniform4ivARB = GL_RegisterProc("glUniform4ivARB"); \
+_glUniformMatrix2fvARB = GL_RegisterProc("glUniformMatrix2fvARB"); \
+_glUniformMatrix3fvARB = GL_RegisterProc("glUniformMatrix3fvARB"); \
+_glUniformMatrix4fvARB = GL_RegisterProc("glUniformMatrix4fvARB"); \
+_glGetObjectParameterfvARB = GL_RegisterProc("glGetObjectParameterfvARB"); \
+_glGetObjectParameterivARB = GL_RegisterProc("glGetObjectParameterivARB"); \
+_glGetInfoLogARB = GL_RegisterProc("glGetInfoLogARB"); \
+_glGetAttachedObjectsARB = GL_RegisterProc("glGetAttachedObjectsARB"); \
+_glGetUniformLocationARB = GL_RegisterProc("glGetUniformLocationARB"); \
+_glGetActiveUniformARB = GL_RegisterProc("glGetActiveUniformARB"); \
+_glGetUniformfvARB = GL_RegisterProc("glGetUniformfvARB"); \
+_glGetUniformivARB = GL_RegisterProc("glGetUniformivARB"); \
+_glGetShaderSourceARB = GL_RegisterProc("glGetShaderSourceARB")
+
+#ifndef USE_DEBUG_GLFUNCS
+
+#define dglDeleteObjectARB(obj) _glDeleteObjectARB(obj)
+#define dglGetHandleARB(pname) _glGetHandleARB(pname)
+#define dglDetachObjectARB(containerObj, attachedObj) _glDetachObjectARB(containerObj, attachedObj)
+#define dglCreateShaderObjectARB(shaderType) _glCreateShaderObjectARB(shaderType)
+#define dglShaderSourceARB(shaderObj, count, string, length) _glShaderSourceARB(shaderObj, count, string, length)
+#define dglCompileShaderARB(shaderObj) _glCompileShaderARB(shaderObj)
+#define dglCreateProgramObjectARB() _glCreateProgramObjectARB()
+#define dglAttachObjectARB(containerObj, obj) _glAttachObjectARB(containerObj, obj)
+#define dglLinkProgramARB(programObj) _glLinkProgramARB(programObj)
+#define dglUseProgramObjectARB(programObj) _glUseProgramObjectARB(programObj)
+#define dglValidateProgramARB(programObj) _glValidateProgramARB(programObj)
+#define dglUniform1fARB(location, v0) _glUniform1fARB(location, v0)
+#define dglUniform2fARB(location, v0, v1) _glUniform2fARB(location, v0, v1)
+#define dglUniform3fARB(location, v0, v1, v2) _glUniform3fARB(location, v0, v1, v2)
+#define dglUniform4fARB(location, v0, v1, v2, v3) _glUniform4fARB(location, v0, v1, v2, v3)
+#define dglUniform1iARB(location, v0) _glUniform1iARB(location, v0)
+#define dglUniform2iARB(location, v0, v1) _glUniform2iARB(location, v0, v1)
+#define dglUniform3iARB(location, v0, v1, v2) _glUniform3iARB(location, v0, v1, v2)
+#define dglUniform4iARB(location, v0, v1, v2, v3) _glUniform4iARB(location, v0, v1, v2, v3)
+#define dglUniform1fvARB(location, count, value) _glUniform1fvARB(location, count, value)
+#define dglUniform2fvARB(location, count, value) _glUniform2fvARB(location, count, value)
+#define dglUniform3fvARB(location, count, value) _glUniform3fvARB(location, count, value)
+#define dglUniform4fvARB(location, count, value) _glUniform4fvARB(location, count, value)
+#define dglUniform1ivARB(location, count, value) _glUniform1ivARB(location, count, value)
+#define dglUniform2ivARB(location, count, value) _glUniform2ivARB(location, count, value)
+#define dglUniform3ivARB(location, count, value) _glUniform3ivARB(location, count, value)
+#define dglUniform4ivARB(location, count, value) _glUniform4ivARB(location, count, value)
+#define dglUniformMatrix2fvARB(location, count, transpose, value) _glUniformMatrix2fvARB(location, count, transpose, value)
+#define dglUniformMatrix3fvARB(location, count, transpose, value) _glUniformMatrix3fvARB(location, count, transpose, value)
+#define dglUniformMatrix4fvARB(location, count, transpose, value) _glUniformMatrix4fvARB(location, count, transpose, value)
+#define dglGetObjectParameterfvARB(obj, pname, params) _glGetObjectParameterfvARB(obj, pname, params)
+#define dglGetObjectParameterivARB(obj, pname, params) _glGetObjectParameterivARB(obj, pname, params)
+#define dglGetInfoLogARB(obj, maxLength, length, infoLog) _glGetInfoLogARB(obj, maxLength, length, infoLog)
+#define dglGetAttachedObjectsARB(containerObj, maxCount, count, obj) _glGetAttachedObjectsARB(containerObj, maxCount, count, obj)
+#define dglGetUniformLocationARB(programObj, name) _glGetUniformLocationARB(programObj, name)
+#define dglGetActiveUniformARB(programObj, index, maxLength, length, size, type, name) _glGetActiveUniformARB(programObj, index, maxLength, length, size, type, name)
+#define dglGetUniformfvARB(programObj, location, params) _glGetUniformfvARB(programObj, location, params)
+#define dglGetUniformivARB(programObj, location, params) _glGetUniformivARB(programObj, location, params)
+#define dglGetShaderSourceARB(obj, maxLength, length, source) _glGetShaderSourceARB(obj, maxLength, length, source)
+
+#else
+
+d_inline static void glDeleteObjectARB_DEBUG(GLhandleARB obj, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glDeleteObjectARB(obj=%i)\n", file, line, obj);
+#endif
+    _glDeleteObjectARB(obj);
+    dglLogError("glDeleteObjectARB", file, line);
+}
+
+d_inline static GLhandleARB glGetHandleARB_DEBUG(GLenum pname, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glGetHandleARB(pname=0x%x)\n", file, line, pname);
+#endif
+    _glGetHandleARB(pname);
+    dglLogError("glGetHandleARB", file, line);
+}
+
+d_inline static void glDetachObjectARB_DEBUG(GLhandleARB containerObj, GLhandleARB attachedObj, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glDetachObjectARB(containerObj=%i, attachedObj=%i)\n", file, line, containerObj, attachedObj);
+#endif
+    _glDetachObjectARB(containerObj, attachedObj);
+    dglLogError("glDetachObjectARB", file, line);
+}
+
+d_inline static GLhandleARB glCreateShaderObjectARB_DEBUG(GLenum shaderType, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glCreateShaderObjectARB(shaderType=0x%x)\n", file, line, shaderType);
+#endif
+    _glCreateShaderObjectARB(shaderType);
+    dglLogError("glCreateShaderObjectARB", file, line);
+}
+
+d_inline static void glShaderSourceARB_DEBUG(GLhandleARB shaderObj, GLsizei count, void* string, GLint* length, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glShaderSourceARB(shaderObj=%i, count=0x%x, string=%p, length=%p)\n", file, line, shaderObj, count, string, length);
+#endif
+    _glShaderSourceARB(shaderObj, count, string, length);
+    dglLogError("glShaderSourceARB", file, line);
+}
+
+d_inline static void glCompileShaderARB_DEBUG(GLhandleARB shaderObj, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glCompileShaderARB(shaderObj=%i)\n", file, line, shaderObj);
+#endif
+    _glCompileShaderARB(shaderObj);
+    dglLogError("glCompileShaderARB", file, line);
+}
+
+d_inline static GLhandleARB glCreateProgramObjectARB_DEBUG(const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glCreateProgramObjectARB()\n", file, line);
+#endif
+    _glCreateProgramObjectARB();
+    dglLogError("glCreateProgramObjectARB", file, line);
+}
+
+d_inline static void glAttachObjectARB_DEBUG(GLhandleARB containerObj, GLhandleARB obj, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glAttachObjectARB(containerObj=%i, obj=%i)\n", file, line, containerObj, obj);
+#endif
+    _glAttachObjectARB(containerObj, obj);
+    dglLogError("glAttachObjectARB", file, line);
+}
+
+d_inline static void glLinkProgramARB_DEBUG(GLhandleARB programObj, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glLinkProgramARB(programObj=%i)\n", file, line, programObj);
+#endif
+    _glLinkProgramARB(programObj);
+    dglLogError("glLinkProgramARB", file, line);
+}
+
+d_inline static void glUseProgramObjectARB_DEBUG(GLhandleARB programObj, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glUseProgramObjectARB(programObj=%i)\n", file, line, programObj);
+#endif
+    _glUseProgramObjectARB(programObj);
+    dglLogError("glUseProgramObjectARB", file, line);
+}
+
+d_inline static void glValidateProgramARB_DEBUG(GLhandleARB programObj, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glValidateProgramARB(programObj=%i)\n", file, line, programObj);
+#endif
+    _glValidateProgramARB(programObj);
+    dglLogError("glValidateProgramARB", file, line);
+}
+
+d_inline static void glUniform1fARB_DEBUG(GLint location, GLfloat v0, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glUniform1fARB(location=%i, v0=%f)\n", file, line, location, v0);
+#endif
+    _glUniform1fARB(location, v0);
+    dglLogError("glUniform1fARB", file, line);
+}
+
+d_inline static void glUniform2fARB_DEBUG(GLint location, GLfloat v0, GLfloat v1, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glUniform2fARB(location=%i, v0=%f, v1=%f)\n", file, line, location, v0, v1);
+#endif
+    _glUniform2fARB(location, v0, v1);
+    dglLogError("glUniform2fARB", file, line);
+}
+
+d_inline static void glUniform3fARB_DEBUG(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glUniform3fARB(location=%i, v0=%f, v1=%f, v2=%f)\n", file, line, location, v0, v1, v2);
+#endif
+    _glUniform3fARB(location, v0, v1, v2);
+    dglLogError("glUniform3fARB", file, line);
+}
+
+d_inline static void glUniform4fARB_DEBUG(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glUniform4fARB(location=%i, v0=%f, v1=%f, v2=%f, v3=%f)\n", file, line, location, v0, v1, v2, v3);
+#endif
+    _glUniform4fARB(location, v0, v1, v2, v3);
+    dglLogError("glUniform4fARB", file, line);
+}
+
+d_inline static void glUniform1iARB_DEBUG(GLint location, GLint v0, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glUniform1iARB(location=%i, v0=%i)\n", file, line, location, v0);
+#endif
+    _glUniform1iARB(location, v0);
+    dglLogError("glUniform1iARB", file, line);
+}
+
+d_inline static void glUniform2iARB_DEBUG(GLint location, GLint v0, GLint v1, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glUniform2iARB(location=%i, v0=%i, v1=%i)\n", file, line, location, v0, v1);
+#endif
+    _glUniform2iARB(location, v0, v1);
+    dglLogError("glUniform2iARB", file, line);
+}
+
+d_inline static void glUniform3iARB_DEBUG(GLint location, GLint v0, GLint v1, GLint v2, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glUniform3iARB(location=%i, v0=%i, v1=%i, v2=%i)\n", file, line, location, v0, v1, v2);
+#endif
+    _glUniform3iARB(location, v0, v1, v2);
+    dglLogError("glUniform3iARB", file, line);
+}
+
+d_inline static void glUniform4iARB_DEBUG(GLint location, GLint v0, GLint v1, GLint v2, GLint v3, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glUniform4iARB(location=%i, v0=%i, v1=%i, v2=%i, v3=%i)\n", file, line, location, v0, v1, v2, v3);
+#endif
+    _glUniform4iARB(location, v0, v1, v2, v3);
+    dglLogError("glUniform4iARB", file, line);
+}
+
+d_inline static void glUniform1fvARB_DEBUG(GLint location, GLsizei count, GLfloat* value, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glUniform1fvARB(location=%i, count=0x%x, value=%p)\n", file, line, location, count, value);
+#endif
+    _glUniform1fvARB(location, count, value);
+    dglLogError("glUniform1fvARB", file, line);
+}
+
+d_inline static void glUniform2fvARB_DEBUG(GLint location, GLsizei count, GLfloat* value, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glUniform2fvARB(location=%i, count=0x%x, value=%p)\n", file, line, location, count, value);
+#endif
+    _glUniform2fvARB(location, count, value);
+    dglLogError("glUniform2fvARB", file, line);
+}
+
+d_inline static void glUniform3fvARB_DEBUG(GLint location, GLsizei count, GLfloat* value, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glUniform3fvARB(location=%i, count=0x%x, value=%p)\n", file, line, location, count, value);
+#endif
+    _glUniform3fvARB(location, count, value);
+    dglLogError("glUniform3fvARB", file, line);
+}
+
+d_inline static void glUniform4fvARB_DEBUG(GLint location, GLsizei count, GLfloat* value, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glUniform4fvARB(location=%i, count=0x%x, value=%p)\n", file, line, location, count, value);
+#endif
+    _glUniform4fvARB(location, count, value);
+    dglLogError("glUniform4fvARB", file, line);
+}
+
+d_inline static void glUniform1ivARB_DEBUG(GLint location, GLsizei count, GLint* value, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glUniform1ivARB(location=%i, count=0x%x, value=%p)\n", file, line, location, count, value);
+#endif
+    _glUniform1ivARB(location, count, value);
+    dglLogError("glUniform1ivARB", file, line);
+}
+
+d_inline static void glUniform2ivARB_DEBUG(GLint location, GLsizei count, GLint* value, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glUniform2ivARB(location=%i, count=0x%x, value=%p)\n", file, line, location, count, value);
+#endif
+    _glUniform2ivARB(location, count, value);
+    dglLogError("glUniform2ivARB", file, line);
+}
+
+d_inline static void glUniform3ivARB_DEBUG(GLint location, GLsizei count, GLint* value, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glUniform3ivARB(location=%i, count=0x%x, value=%p)\n", file, line, location, count, value);
+#endif
+    _glUniform3ivARB(location, count, value);
+    dglLogError("glUniform3ivARB", file, line);
+}
+
+d_inline static void glUniform4ivARB_DEBUG(GLint location, GLsizei count, GLint* value, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glUniform4ivARB(location=%i, count=0x%x, value=%p)\n", file, line, location, count, value);
+#endif
+    _glUniform4ivARB(location, count, value);
+    dglLogError("glUniform4ivARB", file, line);
+}
+
+d_inline static void glUniformMatrix2fvARB_DEBUG(GLint location, GLsizei count, GLboolean transpose, GLfloat* value, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glUniformMatrix2fvARB(location=%i, count=0x%x, transpose=%i, value=%p)\n", file, line, location, count, transpose, value);
+#endif
+    _glUniformMatrix2fvARB(location, count, transpose, value);
+    dglLogError("glUniformMatrix2fvARB", file, line);
+}
+
+d_inline static void glUniformMatrix3fvARB_DEBUG(GLint location, GLsizei count, GLboolean transpose, GLfloat* value, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glUniformMatrix3fvARB(location=%i, count=0x%x, transpose=%i, value=%p)\n", file, line, location, count, transpose, value);
+#endif
+    _glUniformMatrix3fvARB(location, count, transpose, value);
+    dglLogError("glUniformMatrix3fvARB", file, line);
+}
+
+d_inline static void glUniformMatrix4fvARB_DEBUG(GLint location, GLsizei count, GLboolean transpose, GLfloat* value, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glUniformMatrix4fvARB(location=%i, count=0x%x, transpose=%i, value=%p)\n", file, line, location, count, transpose, value);
+#endif
+    _glUniformMatrix4fvARB(location, count, transpose, value);
+    dglLogError("glUniformMatrix4fvARB", file, line);
+}
+
+d_inline static void glGetObjectParameterfvARB_DEBUG(GLhandleARB obj, GLenum pname, GLfloat* params, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glGetObjectParameterfvARB(obj=%i, pname=0x%x, params=%p)\n", file, line, obj, pname, params);
+#endif
+    _glGetObjectParameterfvARB(obj, pname, params);
+    dglLogError("glGetObjectParameterfvARB", file, line);
+}
+
+d_inline static void glGetObjectParameterivARB_DEBUG(GLhandleARB obj, GLenum pname, GLint* params, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glGetObjectParameterivARB(obj=%i, pname=0x%x, params=%p)\n", file, line, obj, pname, params);
+#endif
+    _glGetObjectParameterivARB(obj, pname, params);
+    dglLogError("glGetObjectParameterivARB", file, line);
+}
+
+d_inline static void glGetInfoLogARB_DEBUG(GLhandleARB obj, GLsizei maxLength, GLsizei* length, GLcharARB* infoLog, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glGetInfoLogARB(obj=%i, maxLength=0x%x, length=%p, infoLog=%p)\n", file, line, obj, maxLength, length, infoLog);
+#endif
+    _glGetInfoLogARB(obj, maxLength, length, infoLog);
+    dglLogError("glGetInfoLogARB", file, line);
+}
+
+d_inline static void glGetAttachedObjectsARB_DEBUG(GLhandleARB containerObj, GLsizei maxCount, GLsizei* count, GLhandleARB* obj, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glGetAttachedObjectsARB(containerObj=%i, maxCount=0x%x, count=%p, obj=%p)\n", file, line, containerObj, maxCount, count, obj);
+#endif
+    _glGetAttachedObjectsARB(containerObj, maxCount, count, obj);
+    dglLogError("glGetAttachedObjectsARB", file, line);
+}
+
+d_inline static GLint glGetUniformLocationARB_DEBUG(GLhandleARB programObj, GLcharARB* name, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glGetUniformLocationARB(programObj=%i, name=%p)\n", file, line, programObj, name);
+#endif
+    _glGetUniformLocationARB(programObj, name);
+    dglLogError("glGetUniformLocationARB", file, line);
+}
+
+d_inline static void glGetActiveUniformARB_DEBUG(GLhandleARB programObj, GLuint index, GLsizei maxLength, GLsizei* length, GLint* size, GLenum* type, GLcharARB* name, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glGetActiveUniformARB(programObj=%i, index=%i, maxLength=0x%x, length=%p, size=%p, type=%p, name=%p)\n", file, line, programObj, index, maxLength, length, size, type, name);
+#endif
+    _glGetActiveUniformARB(programObj, index, maxLength, length, size, type, name);
+    dglLogError("glGetActiveUniformARB", file, line);
+}
+
+d_inline static void glGetUniformfvARB_DEBUG(GLhandleARB programObj, GLint location, GLfloat* params, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glGetUniformfvARB(programObj=%i, location=%i, params=%p)\n", file, line, programObj, location, params);
+#endif
+    _glGetUniformfvARB(programObj, location, params);
+    dglLogError("glGetUniformfvARB", file, line);
+}
+
+d_inline static void glGetUniformivARB_DEBUG(GLhandleARB programObj, GLint location, GLint* params, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glGetUniformivARB(programObj=%i, location=%i, params=%p)\n", file, line, programObj, location, params);
+#endif
+    _glGetUniformivARB(programObj, location, params);
+    dglLogError("glGetUniformivARB", file, line);
+}
+
+d_inline static void glGetShaderSourceARB_DEBUG(GLhandleARB obj, GLsizei maxLength, GLsizei* length, GLcharARB* source, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glGetShaderSourceARB(obj=%i, maxLength=0x%x, length=%p, source=%p)\n", file, line, obj, maxLength, length, source);
+#endif
+    _glGetShaderSourceARB(obj, maxLength, length, source);
+    dglLogError("glGetShaderSourceARB", file, line);
+}
+
+
+#define dglDeleteObjectARB(obj) glDeleteObjectARB_DEBUG(obj, __FILE__, __LINE__)
+#define dglGetHandleARB(pname) glGetHandleARB_DEBUG(pname, __FILE__, __LINE__)
+#define dglDetachObjectARB(containerObj, attachedObj) glDetachObjectARB_DEBUG(containerObj, attachedObj, __FILE__, __LINE__)
+#define dglCreateShaderObjectARB(shaderType) glCreateShaderObjectARB_DEBUG(shaderType, __FILE__, __LINE__)
+#define dglShaderSourceARB(shaderObj, count, string, length) glShaderSourceARB_DEBUG(shaderObj, count, string, length, __FILE__, __LINE__)
+#define dglCompileShaderARB(shaderObj) glCompileShaderARB_DEBUG(shaderObj, __FILE__, __LINE__)
+#define dglCreateProgramObjectARB() glCreateProgramObjectARB_DEBUG(__FILE__, __LINE__)
+#define dglAttachObjectARB(containerObj, obj) glAttachObjectARB_DEBUG(containerObj, obj, __FILE__, __LINE__)
+#define dglLinkProgramARB(programObj) glLinkProgramARB_DEBUG(programObj, __FILE__, __LINE__)
+#define dglUseProgramObjectARB(programObj) glUseProgramObjectARB_DEBUG(programObj, __FILE__, __LINE__)
+#define dglValidateProgramARB(programObj) glValidateProgramARB_DEBUG(programObj, __FILE__, __LINE__)
+#define dglUniform1fARB(location, v0) glUniform1fARB_DEBUG(location, v0, __FILE__, __LINE__)
+#define dglUniform2fARB(location, v0, v1) glUniform2fARB_DEBUG(location, v0, v1, __FILE__, __LINE__)
+#define dglUniform3fARB(location, v0, v1, v2) glUniform3fARB_DEBUG(location, v0, v1, v2, __FILE__, __LINE__)
+#define dglUniform4fARB(location, v0, v1, v2, v3) glUniform4fARB_DEBUG(location, v0, v1, v2, v3, __FILE__, __LINE__)
+#define dglUniform1iARB(location, v0) glUniform1iARB_DEBUG(location, v0, __FILE__, __LINE__)
+#define dglUniform2iARB(location, v0, v1) glUniform2iARB_DEBUG(location, v0, v1, __FILE__, __LINE__)
+#define dglUniform3iARB(location, v0, v1, v2) glUniform3iARB_DEBUG(location, v0, v1, v2, __FILE__, __LINE__)
+#define dglUniform4iARB(location, v0, v1, v2, v3) glUniform4iARB_DEBUG(location, v0, v1, v2, v3, __FILE__, __LINE__)
+#define dglUniform1fvARB(location, count, value) glUniform1fvARB_DEBUG(location, count, value, __FILE__, __LINE__)
+#define dglUniform2fvARB(location, count, value) glUniform2fvARB_DEBUG(location, count, value, __FILE__, __LINE__)
+#define dglUniform3fvARB(location, count, value) glUniform3fvARB_DEBUG(location, count, value, __FILE__, __LINE__)
+#define dglUniform4fvARB(location, count, value) glUniform4fvARB_DEBUG(location, count, value, __FILE__, __LINE__)
+#define dglUniform1ivARB(location, count, value) glUniform1ivARB_DEBUG(location, count, value, __FILE__, __LINE__)
+#define dglUniform2ivARB(location, count, value) glUniform2ivARB_DEBUG(location, count, value, __FILE__, __LINE__)
+#define dglUniform3ivARB(location, count, value) glUniform3ivARB_DEBUG(location, count, value, __FILE__, __LINE__)
+#define dglUniform4ivARB(location, count, value) glUniform4ivARB_DEBUG(location, count, value, __FILE__, __LINE__)
+#define dglUniformMatrix2fvARB(location, count, transpose, value) glUniformMatrix2fvARB_DEBUG(location, count, transpose, value, __FILE__, __LINE__)
+#define dglUniformMatrix3fvARB(location, count, transpose, value) glUniformMatrix3fvARB_DEBUG(location, count, transpose, value, __FILE__, __LINE__)
+#define dglUniformMatrix4fvARB(location, count, transpose, value) glUniformMatrix4fvARB_DEBUG(location, count, transpose, value, __FILE__, __LINE__)
+#define dglGetObjectParameterfvARB(obj, pname, params) glGetObjectParameterfvARB_DEBUG(obj, pname, params, __FILE__, __LINE__)
+#define dglGetObjectParameterivARB(obj, pname, params) glGetObjectParameterivARB_DEBUG(obj, pname, params, __FILE__, __LINE__)
+#define dglGetInfoLogARB(obj, maxLength, length, infoLog) glGetInfoLogARB_DEBUG(obj, maxLength, length, infoLog, __FILE__, __LINE__)
+#define dglGetAttachedObjectsARB(containerObj, maxCount, count, obj) glGetAttachedObjectsARB_DEBUG(containerObj, maxCount, count, obj, __FILE__, __LINE__)
+#define dglGetUniformLocationARB(programObj, name) glGetUniformLocationARB_DEBUG(programObj, name, __FILE__, __LINE__)
+#define dglGetActiveUniformARB(programObj, index, maxLength, length, size, type, name) glGetActiveUniformARB_DEBUG(programObj, index, maxLength, length, size, type, name, __FILE__, __LINE__)
+#define dglGetUniformfvARB(programObj, location, params) glGetUniformfvARB_DEBUG(programObj, location, params, __FILE__, __LINE__)
+#define dglGetUniformivARB(programObj, location, params) glGetUniformivARB_DEBUG(programObj, location, params, __FILE__, __LINE__)
+#define dglGetShaderSourceARB(obj, maxLength, length, source) glGetShaderSourceARB_DEBUG(obj, maxLength, length, source, __FILE__, __LINE__)
+
+#endif // USE_DEBUG_GLFUNCS
+
+//
+// GL_ARB_vertex_shader
+//
+extern dboolean has_GL_ARB_vertex_shader;
+
+extern PFNGLBINDATTRIBLOCATIONARBPROC _glBindAttribLocationARB;
+extern PFNGLGETACTIVEATTRIBARBPROC _glGetActiveAttribARB;
+extern PFNGLGETATTRIBLOCATIONARBPROC _glGetAttribLocationARB;
+
+#define GL_ARB_vertex_shader_Define() \
+dboolean has_GL_ARB_vertex_shader = false; \
+PFNGLBINDATTRIBLOCATIONARBPROC _glBindAttribLocationARB = NULL; \
+PFNGLGETACTIVEATTRIBARBPROC _glGetActiveAttribARB = NULL; \
+PFNGLGETATTRIBLOCATIONARBPROC _glGetAttribLocationARB = NULL
+
+#define GL_ARB_vertex_shader_Init() \
+has_GL_ARB_vertex_shader = GL_CheckExtension("GL_ARB_vertex_shader"); \
+_glBindAttribLocationARB = GL_RegisterProc("glBindAttribLocationARB"); \
+_glGetActiveAttribARB = GL_RegisterProc("glGetActiveAttribARB"); \
+_glGetAttribLocationARB = GL_RegisterProc("glGetAttribLocationARB")
+
+#ifndef USE_DEBUG_GLFUNCS
+
+#define dglBindAttribLocationARB(programObj, index, name) _glBindAttribLocationARB(programObj, index, name)
+#define dglGetActiveAttribARB(programObj, index, maxLength, length, size, type, name) _glGetActiveAttribARB(programObj, index, maxLength, length, size, type, name)
+#define dglGetAttribLocationARB(programObj, name) _glGetAttribLocationARB(programObj, name)
+
+#else
+
+d_inline static void glBindAttribLocationARB_DEBUG(GLhandleARB programObj, GLuint index, GLcharARB* name, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glBindAttribLocationARB(programObj=%i, index=%i, name=%p)\n", file, line, programObj, index, name);
+#endif
+    _glBindAttribLocationARB(programObj, index, name);
+    dglLogError("glBindAttribLocationARB", file, line);
+}
+
+d_inline static void glGetActiveAttribARB_DEBUG(GLhandleARB programObj, GLuint index, GLsizei maxLength, GLsizei* length, GLint* size, GLenum* type, GLcharARB* name, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glGetActiveAttribARB(programObj=%i, index=%i, maxLength=0x%x, length=%p, size=%p, type=%p, name=%p)\n", file, line, programObj, index, maxLength, length, size, type, name);
+#endif
+    _glGetActiveAttribARB(programObj, index, maxLength, length, size, type, name);
+    dglLogError("glGetActiveAttribARB", file, line);
+}
+
+d_inline static GLint glGetAttribLocationARB_DEBUG(GLhandleARB programObj, GLcharARB* name, const char* file, int line) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("file = %s, line = %i, glGetAttribLocationARB(programObj=%i, name=%p)\n", file, line, programObj, name);
+#endif
+    _glGetAttribLocationARB(programObj, name);
+    dglLogError("glGetAttribLocationARB", file, line);
+}
+
+
+#define dglBindAttribLocationARB(programObj, index, name) glBindAttribLocationARB_DEBUG(programObj, index, name, __FILE__, __LINE__)
+#define dglGetActiveAttribARB(programObj, index, maxLength, length, size, type, name) glGetActiveAttribARB_DEBUG(programObj, index, maxLength, length, size, type, name, __FILE__, __LINE__)
+#define dglGetAttribLocationARB(programObj, name) glGetAttribLocationARB_DEBUG(programObj, name, __FILE__, __LINE__)
+
+#endif // USE_DEBUG_GLFUNCS
+
+//
+// GL_ARB_fragment_shader
+//
+extern dboolean has_GL_ARB_fragment_shader;
+
+#define GL_ARB_fragment_shader_Define() \
+dboolean has_GL_ARB_fragment_shader = false;
+
+#define GL_ARB_fragment_shader_Init() \
+has_GL_ARB_fragment_shader = GL_CheckExtension("GL_ARB_fragment_shader");
+
 #endif // __DGL_H__
 
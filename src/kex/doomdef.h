@@ -274,6 +274,7 @@ enum {
     GF_ALLOWCHEATS      = (1 << 7),
     GF_FRIENDLYFIRE     = (1 << 8),
     GF_KEEPITEMS        = (1 << 9),
+    GF_DORMANTMONSTERS  = (1 << 10),    // not demo compatible, see P_MobjDormant
 };
 
 // 20120209 villsa - compatibility flags
@@ -281,7 +282,8 @@ enum {
     COMPATF_COLLISION   = (1 << 0),     // don't use maxradius for mobj position checks
     COMPATF_MOBJPASS    = (1 << 1),     // allow mobjs to stand on top one another
     COMPATF_LIMITPAIN   = (1 << 2),     // pain elemental limited to 17 lost souls?
-    COMPATF_REACHITEMS  = (1 << 3)      // able to grab high items by bumping
+    COMPATF_REACHITEMS  = (1 << 3),     // able to grab high items by bumping
+    COMPATF_NOINTERCEPTCAP = (1 << 4)   // traces keep collecting past MAXINTERCEPTS (clear in older demos)
 };
 
 extern dboolean windowpause;
@@ -49,6 +49,8 @@ extern  dboolean    respawnitem;
 extern  dboolean    fastparm;       // checkparm of -fast
 extern  dboolean    nolights;
 extern  dboolean    devparm;        // DEBUG: launched with -devparm
+extern  dboolean    timingdemo;     // run demo as fast as possible, report stats
+extern  dboolean    nodrawparm;     // -nodraw/-headless: playsim only, no video/audio
 
 
 // -------------------------------------------
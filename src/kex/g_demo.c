@@ -39,6 +39,9 @@
 #include "m_misc.h"
 #include "m_random.h"
 #include "con_console.h"
+#include "i_system.h"
+#include "r_main.h"
+#include "d_main.h"
 
 void        G_DoLoadLevel(void);
 dboolean    G_CheckDemoStatus(void);
@@ -57,9 +60,65 @@ byte*           demoend;
 dboolean        singledemo      = false;    // quit after playing a demo from cmdline
 dboolean        endDemo;
 dboolean        iwadDemo        = false;
+dboolean        timingdemo      = false;    // run demo one tic per frame and report timings
 
 extern int      starttime;
 
+//
+// DEMO HASHES
+// With -demohash <tics> a recorded demo carries a hash record every
+// that many tics: a 'H' tag and 16 bits for each P_WorldHashes value,
+// taken before the tic runs. The interval goes in the header byte
+// after "DM64", which is 0 in older demos. Playback compares each
+// record against its own state and reports the first divergence.
+//
+
+#define DEMOHASHTAG     'H'
+
+static int      demohashinterval = 0;
+static int      demohashtic = 0;
+static int      demohashchecks = 0;
+static dboolean demohashfailed = false;
+
+static const char* demohashnames[NUMWORLDHASHES] = {
+    "rng",
+    "sectors",
+    "players",
+    "mobjs"
+};
+
+//
+// G_DemoHashes
+//
+
+static void G_DemoHashes(unsigned int* hashes) {
+    int i;
+
+    if(gamestate != GS_LEVEL) {
+        for(i = 0; i < NUMWORLDHASHES; i++) {
+            hashes[i] = 0;
+        }
+        return;
+    }
+
+    P_WorldHashes(hashes);
+}
+
+//
+// TIMEDEMO STATISTICS
+//
+
+static char     timedemoname[256];
+static uint32*  timedemoframes = NULL;      // frame times in microseconds
+static int      timedemonumframes = 0;
+static int      timedemomaxframes = 0;
+static uint64   timedemototaltime = 0;     // sum of the timed frames
+static uint64   timedemolasttime = 0;
+static int      timedemostarttic = 0;
+static uint64   timedemodrawcalls = 0;
+static uint64   timedemobindcalls = 0;
+static uint64   timedemovertices = 0;
+
 //
 // DEMO RECORDING
 //
@@ -88,6 +147,88 @@ void G_ReadDemoTiccmd(ticcmd_t* cmd) {
 }
 
 
+//
+// G_ReadDemoHash
+// Called once per tic before the ticcmds are read
+//
+
+void G_ReadDemoHash(void) {
+    unsigned int hashes[NUMWORLDHASHES];
+    char bad[64];
+    int i;
+
+    if(!demohashinterval || *demo_p == DEMOMARKER) {
+        return;
+    }
+
+    if(demohashtic++ % demohashinterval) {
+        return;
+    }
+
+    if(*demo_p != DEMOHASHTAG) {
+        I_Error("G_ReadDemoHash: missing hash record at tic %i", demohashtic - 1);
+        return;
+    }
+
+    demo_p++;
+    G_DemoHashes(hashes);
+    bad[0] = 0;
+
+    for(i = 0; i < NUMWORLDHASHES; i++) {
+        unsigned int value = demo_p[0] | (demo_p[1] << 8);
+
+        demo_p += 2;
+
+        if(value != (hashes[i] & 0xffff)) {
+            dstrcat(bad, " ");
+            dstrcat(bad, demohashnames[i]);
+        }
+    }
+
+    demohashchecks++;
+
+    // only the first divergence means anything,
+    // everything after it follows from it
+    if(bad[0] && !demohashfailed) {
+        demohashfailed = true;
+        I_Printf("G_ReadDemoHash: desync at demo tic %i (map %i, leveltime %i):%s\n",
+                 demohashtic - 1, gamemap, leveltime, bad);
+    }
+}
+
+//
+// G_WriteDemoHash
+// Called once per tic before the ticcmds are written
+//
+
+void G_WriteDemoHash(void) {
+    unsigned int hashes[NUMWORLDHASHES];
+    byte buf[1 + NUMWORLDHASHES * 2];
+    byte* p = buf;
+    int i;
+
+    if(!demohashinterval) {
+        return;
+    }
+
+    if(demohashtic++ % demohashinterval) {
+        return;
+    }
+
+    G_DemoHashes(hashes);
+
+    *p++ = DEMOHASHTAG;
+
+    for(i = 0; i < NUMWORLDHASHES; i++) {
+        *p++ = hashes[i] & 0xff;
+        *p++ = (hashes[i] >> 8) & 0xff;
+    }
+
+    if(fwrite(buf, p-buf, 1, demofp) != 1) {
+        I_Error("G_WriteDemoHash: error writing demo");
+    }
+}
+
 //
 // G_WriteDemoTiccmd
 //
@@ -159,6 +300,15 @@ void G_RecordDemo(const char* name) {
 
     CON_DPrintf("--------Recording %s--------\n", demoname);
 
+    demohashinterval = 0;
+    demohashtic = 0;
+
+    i = M_CheckParm("-demohash");
+    if(i && i < myargc-1) {
+        demohashinterval = datoi(myargv[i+1]);
+        demohashinterval = BETWEEN(1, 255, demohashinterval);
+    }
+
     demostart = dm_p = malloc(1000);
 
     G_InitNew(startskill, startmap);
@@ -167,7 +317,7 @@ void G_RecordDemo(const char* name) {
     *dm_p++ = 'M';
     *dm_p++ = '6';
     *dm_p++ = '4';
-    *dm_p++ = '\0';
+    *dm_p++ = (byte)demohashinterval;
     
     *dm_p++ = gameskill;
     *dm_p++ = gamemap;
@@ -223,6 +373,10 @@ void G_PlayDemo(const char* name) {
     endDemo = false;
 
     p = M_CheckParm("-playdemo");
+    if(!p) {
+        p = M_CheckParm("-timedemo");
+    }
+
     if(p && p < myargc-1) {
         // 20120107 bkw: add .lmp extension if missing.
         if(dstrrchr(myargv[p+1], '.')) {
@@ -261,7 +415,11 @@ void G_PlayDemo(const char* name) {
     demo_p++;
     demo_p++;
     demo_p++;
-    demo_p++;
+
+    demohashinterval = *demo_p++;
+    demohashtic = 0;
+    demohashchecks = 0;
+    demohashfailed = false;
 
     startskill      = *demo_p++;
     startmap        = *demo_p++;
@@ -315,6 +473,193 @@ void G_PlayDemo(const char* name) {
     iwadDemo = false;
 }
 
+//
+// G_TimeDemo
+// Plays back a demo one tic per rendered frame as fast as
+// possible, then reports frame timing statistics and quits
+//
+
+void G_TimeDemo(const char* name) {
+    char* ext;
+    int len;
+
+    len = MIN(dstrlen(name), (int)sizeof(timedemoname) - 1);
+    dstrncpy(timedemoname, name, len);
+    timedemoname[len] = 0;
+
+    if((ext = dstrrchr(timedemoname, '.'))) {
+        *ext = 0;
+    }
+
+    timingdemo = true;
+    singledemo = true;
+
+    timedemonumframes = 0;
+    timedemototaltime = 0;
+    timedemolasttime = 0;
+    timedemodrawcalls = 0;
+    timedemobindcalls = 0;
+    timedemovertices = 0;
+
+    G_PlayDemo(name);
+}
+
+//
+// G_TimeDemoFrame
+// Called after each frame has been rendered
+//
+
+void G_TimeDemoFrame(void) {
+    uint64 now;
+
+    // intermissions and level loads aren't timed; the next
+    // level frame starts over from its own timestamp
+    if(gamestate != GS_LEVEL) {
+        timedemolasttime = 0;
+        return;
+    }
+
+    now = I_GetTimeUS();
+
+    // first frame of a level only establishes the starting time
+    // since it also includes the level load and precache
+    if(!timedemolasttime) {
+        if(!timedemonumframes) {
+            timedemostarttic = gametic;
+        }
+    }
+    else {
+        if(timedemonumframes >= timedemomaxframes) {
+            timedemomaxframes = timedemomaxframes ? timedemomaxframes << 1 : 4096;
+            timedemoframes = Z_Realloc(timedemoframes,
+                                       timedemomaxframes * sizeof(uint32), PU_STATIC, 0);
+        }
+
+        timedemoframes[timedemonumframes++] = (uint32)(now - timedemolasttime);
+        timedemototaltime += now - timedemolasttime;
+
+        timedemodrawcalls += glDrawCalls;
+        timedemobindcalls += glBindCalls;
+        timedemovertices += vertCount;
+    }
+
+    timedemolasttime = now;
+
+    glDrawCalls = 0;
+    glBindCalls = 0;
+    vertCount = 0;
+}
+
+//
+// G_CompareFrameTime
+//
+
+static int G_CompareFrameTime(const void* a, const void* b) {
+    uint32 x = *(const uint32*)a;
+    uint32 y = *(const uint32*)b;
+
+    if(x < y) {
+        return -1;
+    }
+
+    if(x > y) {
+        return 1;
+    }
+
+    return 0;
+}
+
+//
+// G_FrameTimePercentile
+// Nearest-rank percentile of a sorted frame time list
+//
+
+static float G_FrameTimePercentile(uint32* sorted, int count, int percent) {
+    int rank = (count * percent + 99) / 100;
+
+    if(rank < 1) {
+        rank = 1;
+    }
+
+    return (float)sorted[rank - 1] / 1000.0f;
+}
+
+//
+// G_TimeDemoReport
+// Prints the timedemo results and writes them out as json
+//
+
+static void G_TimeDemoReport(void) {
+    FILE* f;
+    char filename[256];
+    uint32* sorted;
+    int count = timedemonumframes;
+    int tics;
+    float total;
+    float avg, p50, p95, p99, best, worst;
+    float fps;
+
+    if(count <= 0) {
+        I_Printf("G_TimeDemoReport: no frames rendered\n");
+        return;
+    }
+
+    sorted = Z_Malloc(count * sizeof(uint32), PU_STATIC, 0);
+    dmemcpy(sorted, timedemoframes, count * sizeof(uint32));
+    qsort(sorted, count, sizeof(uint32), G_CompareFrameTime);
+
+    tics    = gametic - timedemostarttic;
+    total   = (float)timedemototaltime / 1000.0f;
+    avg     = total / count;
+    p50     = G_FrameTimePercentile(sorted, count, 50);
+    p95     = G_FrameTimePercentile(sorted, count, 95);
+    p99     = G_FrameTimePercentile(sorted, count, 99);
+    best    = (float)sorted[0] / 1000.0f;
+    worst   = (float)sorted[count - 1] / 1000.0f;
+    fps     = total > 0 ? (count * 1000.0f) / total : 0;
+
+    Z_Free(sorted);
+
+    I_Printf("--------Timedemo %s--------\n", timedemoname);
+    I_Printf("timed %i gametics in %i frames (%.3f ms): %.2f fps\n", tics, count, total, fps);
+    I_Printf("frame time: avg %.3f ms, min %.3f ms, max %.3f ms\n", avg, best, worst);
+    I_Printf("frame time: p50 %.3f ms, p95 %.3f ms, p99 %.3f ms\n", p50, p95, p99);
+    I_Printf("per frame: %.1f draw calls, %.1f texture binds, %.1f vertices\n",
+             (float)timedemodrawcalls / count,
+             (float)timedemobindcalls / count,
+             (float)timedemovertices / count);
+
+    dsprintf(filename, "%s-timedemo.json", timedemoname);
+
+    if(!(f = fopen(filename, "w"))) {
+        I_Printf("G_TimeDemoReport: couldn't write %s\n", filename);
+        return;
+    }
+
+    fprintf(f, "{\n");
+    fprintf(f, "    \"demo\": \"%s\",\n", timedemoname);
+    fprintf(f, "    \"gametics\": %i,\n", tics);
+    fprintf(f, "    \"frames\": %i,\n", count);
+    fprintf(f, "    \"total_ms\": %.3f,\n", total);
+    fprintf(f, "    \"fps\": %.3f,\n", fps);
+    fprintf(f, "    \"frametime_ms\": {\n");
+    fprintf(f, "        \"avg\": %.3f,\n", avg);
+    fprintf(f, "        \"min\": %.3f,\n", best);
+    fprintf(f, "        \"max\": %.3f,\n", worst);
+    fprintf(f, "        \"p50\": %.3f,\n", p50);
+    fprintf(f, "        \"p95\": %.3f,\n", p95);
+    fprintf(f, "        \"p99\": %.3f\n", p99);
+    fprintf(f, "    },\n");
+    fprintf(f, "    \"drawcalls\": %llu,\n", (unsigned long long)timedemodrawcalls);
+    fprintf(f, "    \"bindcalls\": %llu,\n", (unsigned long long)timedemobindcalls);
+    fprintf(f, "    \"vertices\": %llu\n", (unsigned long long)timedemovertices);
+    fprintf(f, "}\n");
+
+    fclose(f);
+
+    I_Printf("wrote %s\n", filename);
+}
+
 //
 // G_CheckDemoStatus
 // Called after a death or level completion to allow demos to be cleaned up
@@ -332,6 +677,21 @@ dboolean G_CheckDemoStatus(void) {
     }
 
     if(demoplayback) {
+        if(timingdemo) {
+            G_TimeDemoReport();
+            timingdemo = false;
+        }
+
+        if(demohashinterval && !demohashfailed) {
+            I_Printf("G_CheckDemoStatus: %i hash checks passed\n", demohashchecks);
+        }
+
+        demohashinterval = 0;
+
+        if(nodrawparm) {
+            D_HeadlessReport();
+        }
+
         if(singledemo) {
             I_Quit();
         }
@@ -30,8 +30,12 @@ dboolean G_CheckDemoStatus(void);
 
 void G_RecordDemo(const char* name);
 void G_PlayDemo(const char* name);
+void G_TimeDemo(const char* name);
+void G_TimeDemoFrame(void);
 void G_ReadDemoTiccmd(ticcmd_t* cmd);
 void G_WriteDemoTiccmd(ticcmd_t* cmd);
+void G_ReadDemoHash(void);
+void G_WriteDemoHash(void);
 
 extern char             demoname[256];  // name of demo lump
 extern dboolean         demorecording;  // currently recording a demo
@@ -143,6 +143,7 @@ NETCVAR_PARAM(sv_lockmonsters,  0,  gameflags,      GF_LOCKMONSTERS);
 NETCVAR_PARAM(sv_allowcheats,   0,  gameflags,      GF_ALLOWCHEATS);
 NETCVAR_PARAM(sv_friendlyfire,  0,  gameflags,      GF_FRIENDLYFIRE);
 NETCVAR_PARAM(sv_keepitems,     0,  gameflags,      GF_KEEPITEMS);
+NETCVAR_PARAM(sv_dormantmonsters, 0, gameflags,     GF_DORMANTMONSTERS);
 NETCVAR_PARAM(p_allowjump,      0,  gameflags,      GF_ALLOWJUMP);
 NETCVAR_PARAM(p_autoaim,        1,  gameflags,      GF_ALLOWAUTOAIM);
 NETCVAR_PARAM(compat_collision, 1,  compatflags,    COMPATF_COLLISION);
@@ -150,6 +151,17 @@ NETCVAR_PARAM(compat_mobjpass,  1,  compatflags,    COMPATF_MOBJPASS);
 NETCVAR_PARAM(compat_limitpain, 1,  compatflags,    COMPATF_LIMITPAIN);
 NETCVAR_PARAM(compat_grabitems, 1,  compatflags,    COMPATF_REACHITEMS);
 
+NETCVAR_CMD(compat_intercepts, 1) {
+    // inverted: the cap is the original behavior, so older demos
+    // (which have the bit clear) keep replaying with it
+    if(cvar->value > 0) {
+        compatflags &= ~COMPATF_NOINTERCEPTCAP;
+    }
+    else {
+        compatflags |= COMPATF_NOINTERCEPTCAP;
+    }
+}
+
 CVAR_EXTERNAL(v_mlook);
 CVAR_EXTERNAL(v_mlookinvert);
 CVAR_EXTERNAL(v_yaxismove);
@@ -175,10 +187,12 @@ void G_RegisterCvars(void) {
     CON_CvarRegister(&sv_allowcheats);
     CON_CvarRegister(&sv_friendlyfire);
     CON_CvarRegister(&sv_keepitems);
+    CON_CvarRegister(&sv_dormantmonsters);
     CON_CvarRegister(&compat_collision);
     CON_CvarRegister(&compat_mobjpass);
     CON_CvarRegister(&compat_limitpain);
     CON_CvarRegister(&compat_grabitems);
+    CON_CvarRegister(&compat_intercepts);
 }
 
 //
@@ -560,6 +574,446 @@ static CMD(EndDemo) {
     endDemo = true;
 }
 
+//
+// PTR_BenchTraverse
+//
+
+static dboolean PTR_BenchTraverse(intercept_t* in) {
+    return true;
+}
+
+//
+// G_CmdBenchTrace
+// Times P_AimLineAttack and a full hitscan-style P_PathTraverse
+// fanned out around the player. The traverser visits every
+// intercept without damaging anything, so the map is untouched
+//
+
+static CMD(BenchTrace) {
+    mobj_t* mo;
+    int count = 4096;
+    int maxcount = 0;
+    int i;
+    uint64 start;
+    uint64 aimtime;
+    uint64 tracetime;
+
+    if(gamestate != GS_LEVEL) {
+        return;
+    }
+
+    if(param[0]) {
+        count = datoi(param[0]);
+
+        if(count <= 0) {
+            return;
+        }
+    }
+
+    mo = players[consoleplayer].mo;
+
+    start = I_GetTimeUS();
+
+    for(i = 0; i < count; i++) {
+        P_AimLineAttack(mo, (angle_t)i * (ANGLE_MAX / count), 0, MISSILERANGE);
+    }
+
+    aimtime = I_GetTimeUS() - start;
+    start = I_GetTimeUS();
+
+    for(i = 0; i < count; i++) {
+        angle_t an = ((angle_t)i * (ANGLE_MAX / count)) >> ANGLETOFINESHIFT;
+        fixed_t x2 = mo->x + F2INT(MISSILERANGE) * finecosine[an];
+        fixed_t y2 = mo->y + F2INT(MISSILERANGE) * finesine[an];
+
+        P_PathTraverse(mo->x, mo->y, x2, y2, PT_ADDLINES|PT_ADDTHINGS, PTR_BenchTraverse);
+
+        if(intercept_p - intercepts > maxcount) {
+            maxcount = intercept_p - intercepts;
+        }
+    }
+
+    tracetime = I_GetTimeUS() - start;
+
+    CON_Printf(WHITE, "P_AimLineAttack: %i calls, %.3f us each\n",
+               count, (float)aimtime / count);
+    CON_Printf(WHITE, "P_PathTraverse: %i traces, %.3f us each, up to %i intercepts\n",
+               count, (float)tracetime / count, maxcount);
+}
+
+//
+// G_CmdBenchSights
+// Times count (default 200) P_ScanSights passes over the level as
+// it stands, serially and on 2, 4 and 8 threads, and checks that
+// every threaded pass sets the same MF_SEETARGET flags as the
+// serial one. The sight cache is flushed before each pass so every
+// check is traced, and the flags are put back afterwards
+//
+
+static CMD(BenchSights) {
+    mobj_t*     mo;
+    byte*       flags;
+    int         count = 200;
+    int         nummobjs = 0;
+    int         numchecks = 0;
+    int         threads;
+    int         bad;
+    int         i;
+    uint64      start;
+    uint64      time;
+    uint64      serialtime = 0;
+
+    if(gamestate != GS_LEVEL) {
+        return;
+    }
+
+    if(param[0]) {
+        count = datoi(param[0]);
+
+        if(count <= 0) {
+            return;
+        }
+    }
+
+    for(mo = mobjhead.next; mo != &mobjhead; mo = mo->next) {
+        if(mo->flags & MF_COUNTKILL && mo->tics != 1 && mo->target) {
+            numchecks++;
+        }
+
+        nummobjs++;
+    }
+
+    // [0] is the flags as the game left them, [1] the serial result
+    flags = (byte*)Z_Malloc(nummobjs * 2 + 1, PU_STATIC, 0);
+
+    for(i = 0, mo = mobjhead.next; mo != &mobjhead; mo = mo->next, i++) {
+        flags[i*2+0] = (mo->flags & MF_SEETARGET) != 0;
+    }
+
+    for(threads = 1; threads <= 8; threads <<= 1) {
+        start = I_GetTimeUS();
+
+        for(i = 0; i < count; i++) {
+            P_InvalidateSightCache();
+            P_ScanSightsThreads(threads, 1);
+        }
+
+        time = I_GetTimeUS() - start;
+        bad = 0;
+
+        for(i = 0, mo = mobjhead.next; mo != &mobjhead; mo = mo->next, i++) {
+            byte seen = (mo->flags & MF_SEETARGET) != 0;
+
+            if(threads == 1) {
+                flags[i*2+1] = seen;
+                serialtime = time;
+            }
+            else if(flags[i*2+1] != seen) {
+                bad++;
+            }
+        }
+
+        CON_Printf(bad ? RED : WHITE, "%i thread(s): %.1f us per scan of %i checks, %.2fx, %i mismatches\n",
+                   threads, (float)time / count, numchecks,
+                   time ? (float)serialtime / time : 0, bad);
+    }
+
+    for(i = 0, mo = mobjhead.next; mo != &mobjhead; mo = mo->next, i++) {
+        if(flags[i*2+0]) {
+            mo->flags |= MF_SEETARGET;
+        }
+        else {
+            mo->flags &= ~MF_SEETARGET;
+        }
+    }
+
+    P_InvalidateSightCache();
+    Z_Free(flags);
+}
+
+//
+// G_CmdBenchBlockMap
+// Rebuilds the level's blockmap at each cell size from 32 to 512
+// and times P_CheckPosition for the player at the same random
+// points. Pickups are masked off so nothing in the map changes,
+// and the level's own blockmap is put back afterwards
+//
+
+static CMD(BenchBlockMap) {
+    mobj_t*         mo;
+    fixed_t*        pts;
+    fixed_t         w;
+    fixed_t         h;
+    unsigned int    seed = 0x2545f491;
+    int             count = 100000;
+    int             units;
+    int             flags;
+    int             cells;
+    int             entries;
+    int             i;
+    uint64          start;
+    uint64          time;
+
+    if(gamestate != GS_LEVEL) {
+        return;
+    }
+
+    if(demoplayback || demorecording || netgame) {
+        CON_Warnf("benchblockmap: not available in demos or netgames\n");
+        return;
+    }
+
+    if(param[0]) {
+        count = datoi(param[0]);
+
+        if(count <= 0) {
+            return;
+        }
+    }
+
+    mo = players[consoleplayer].mo;
+    pts = (fixed_t*)Z_Malloc(sizeof(fixed_t) * count * 2, PU_STATIC, 0);
+    w = bmapwidth << MAPBLOCKSHIFT;
+    h = bmapheight << MAPBLOCKSHIFT;
+
+    for(i = 0; i < count; i++) {
+        // xorshift; leaves the game's random tables alone
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        pts[i*2+0] = bmaporgx + (fixed_t)(seed % (unsigned int)w);
+
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        pts[i*2+1] = bmaporgy + (fixed_t)(seed % (unsigned int)h);
+    }
+
+    flags = mo->flags;
+    mo->flags &= ~MF_PICKUP;
+
+    for(units = 32; units <= 512; units <<= 1) {
+        P_SetBlockMapSize(units);
+
+        cells = bmapwidth * bmapheight;
+        entries = 0;
+
+        for(i = 0; i < cells; i++) {
+            int* list;
+
+            for(list = blockmaplump + blockmap[i]; *list != -1; list++) {
+                entries++;
+            }
+        }
+
+        start = I_GetTimeUS();
+
+        for(i = 0; i < count; i++) {
+            P_CheckPosition(mo, pts[i*2+0], pts[i*2+1]);
+        }
+
+        time = I_GetTimeUS() - start;
+
+        CON_Printf(WHITE, "%3i units: %ix%i cells, %.2f lines/cell, %.3f us per check\n",
+                   units, bmapwidth, bmapheight, (float)entries / cells,
+                   (float)time / count);
+    }
+
+    mo->flags = flags;
+    P_SetBlockMapSize(0);
+
+    Z_Free(pts);
+}
+
+//
+// G_RejectedPair
+//
+
+static dboolean G_RejectedPair(sector_t* s1, sector_t* s2) {
+    int pnum = (s1 - sectors) * numsectors + (s2 - sectors);
+
+    return (rejectmatrix[pnum >> 3] & (1 << (pnum & 7))) != 0;
+}
+
+//
+// G_CmdTestReject
+// Traces every pair the REJECT table rules out, ignoring the
+// table, and counts the ones the sight check would have passed.
+// Pairs are every mobj against every other one, then the middle
+// of every step'th subsector (default 1), looking from just off
+// its floor and ceiling at the other's floor-to-ceiling column
+//
+
+static CMD(TestReject) {
+    mobj_t*     t1;
+    mobj_t*     t2;
+    fixed_t*    mid;
+    int         step = 1;
+    int         checked = 0;
+    int         bad = 0;
+    int         i;
+    int         j;
+    int         k;
+    uint64      start;
+
+    if(gamestate != GS_LEVEL) {
+        return;
+    }
+
+    if(param[0]) {
+        step = datoi(param[0]);
+
+        if(step <= 0) {
+            return;
+        }
+    }
+
+    start = I_GetTimeUS();
+
+    for(t1 = mobjhead.next; t1 != &mobjhead; t1 = t1->next) {
+        for(t2 = mobjhead.next; t2 != &mobjhead; t2 = t2->next) {
+            if(t1 == t2 || !G_RejectedPair(t1->subsector->sector, t2->subsector->sector)) {
+                continue;
+            }
+
+            checked++;
+
+            if(P_TraceSight(t1->x, t1->y, t1->z + t1->height - (t1->height >> 2),
+                            t2->x, t2->y, t2->z, t2->z + t2->height)) {
+                bad++;
+            }
+        }
+    }
+
+    // subsectors are convex, so the average of their seg
+    // starts is always inside
+    mid = (fixed_t*)Z_Malloc(sizeof(fixed_t) * numsubsectors * 2, PU_STATIC, 0);
+
+    for(i = 0; i < numsubsectors; i++) {
+        subsector_t* sub = &subsectors[i];
+        int64 x = 0;
+        int64 y = 0;
+
+        for(k = 0; k < sub->numlines; k++) {
+            x += segs[sub->firstline + k].v1->x;
+            y += segs[sub->firstline + k].v1->y;
+        }
+
+        mid[i*2+0] = sub->numlines ? (fixed_t)(x / sub->numlines) : 0;
+        mid[i*2+1] = sub->numlines ? (fixed_t)(y / sub->numlines) : 0;
+    }
+
+    for(i = 0; i < numsubsectors; i += step) {
+        sector_t* s1 = subsectors[i].sector;
+
+        for(j = 0; j < numsubsectors; j += step) {
+            sector_t* s2 = subsectors[j].sector;
+            fixed_t eye[2];
+
+            if(s1 == s2 || !G_RejectedPair(s1, s2)) {
+                continue;
+            }
+
+            eye[0] = s1->floorheight + FRACUNIT;
+            eye[1] = s1->ceilingheight - FRACUNIT;
+
+            for(k = 0; k < 2; k++) {
+                checked++;
+
+                if(P_TraceSight(mid[i*2+0], mid[i*2+1], eye[k],
+                                mid[j*2+0], mid[j*2+1], s2->floorheight, s2->ceilingheight)) {
+                    bad++;
+                    break;
+                }
+            }
+        }
+    }
+
+    Z_Free(mid);
+
+    CON_Printf(bad ? RED : WHITE, "REJECT: %i of %i rejected sight lines are clear (%i ms)\n",
+               bad, checked, (int)((I_GetTimeUS() - start) / 1000));
+}
+
+//
+// G_SnapshotAllowed
+//
+
+static dboolean G_SnapshotAllowed(void) {
+    if(gamestate != GS_LEVEL) {
+        return false;
+    }
+
+    if(netgame || demoplayback || demorecording) {
+        CON_Warnf("Snapshots are not available in demos or netgames\n");
+        return false;
+    }
+
+    return true;
+}
+
+static savesnapshot_t quicksnapshot;
+
+//
+// G_CmdSnapshot
+// Keeps the current level in memory for restoresnapshot
+//
+
+static CMD(Snapshot) {
+    uint64 start;
+
+    if(!G_SnapshotAllowed()) {
+        return;
+    }
+
+    start = I_GetTimeUS();
+    P_SaveSnapshot(&quicksnapshot);
+
+    CON_Printf(WHITE, "Snapshot: %i bytes in %.3f ms\n", quicksnapshot.size,
+               (float)(I_GetTimeUS() - start) / 1000.0f);
+}
+
+//
+// G_CmdRestoreSnapshot
+//
+
+static CMD(RestoreSnapshot) {
+    if(!G_SnapshotAllowed()) {
+        return;
+    }
+
+    if(!P_LoadSnapshot(&quicksnapshot)) {
+        CON_Warnf("No snapshot for this map\n");
+    }
+}
+
+//
+// G_CmdRewind
+// Steps back through the snapshots taken every p_snapshottics
+//
+
+static CMD(Rewind) {
+    int count = 1;
+    int tics;
+
+    if(!G_SnapshotAllowed()) {
+        return;
+    }
+
+    if(param[0]) {
+        count = datoi(param[0]);
+    }
+
+    tics = P_RewindSnapshot(count);
+
+    if(tics < 0) {
+        CON_Warnf("Nothing to rewind to (is p_snapshottics set?)\n");
+        return;
+    }
+
+    CON_Printf(WHITE, "Rewound %i tics\n", tics);
+}
+
 //
 // G_SaveDefaults
 //
@@ -872,6 +1326,7 @@ static void G_SetGameFlags(void) {
     if(sv_allowcheats.value > 0)   gameflags |= GF_ALLOWCHEATS;
     if(sv_friendlyfire.value > 0)  gameflags |= GF_FRIENDLYFIRE;
     if(sv_keepitems.value > 0)     gameflags |= GF_KEEPITEMS;
+    if(sv_dormantmonsters.value > 0) gameflags |= GF_DORMANTMONSTERS;
     if(p_allowjump.value > 0)      gameflags |= GF_ALLOWJUMP;
     if(p_autoaim.value > 0)        gameflags |= GF_ALLOWAUTOAIM;
 
@@ -879,6 +1334,7 @@ static void G_SetGameFlags(void) {
     if(compat_mobjpass.value > 0)  compatflags |= COMPATF_MOBJPASS;
     if(compat_limitpain.value > 0) compatflags |= COMPATF_LIMITPAIN;
     if(compat_grabitems.value > 0) compatflags |= COMPATF_REACHITEMS;
+    if(compat_intercepts.value <= 0) compatflags |= COMPATF_NOINTERCEPTCAP;
 }
 
 //
@@ -1052,6 +1508,14 @@ void G_Ticker(void) {
         // and build new consistancy check
         buf = (gametic / ticdup) % BACKUPTICS;
 
+        if(demoplayback && gameaction == ga_nothing) {
+            G_ReadDemoHash();
+        }
+
+        if(demorecording) {
+            G_WriteDemoHash();
+        }
+
         for(i = 0; i < MAXPLAYERS; i++) {
             if(playeringame[i]) {
                 cmd = &players[i].cmd;
@@ -1636,6 +2100,13 @@ void G_Init(void) {
     G_AddCommand("setcamerastatic", CMD_PlayerCamera, 0);
     G_AddCommand("setcamerachase", CMD_PlayerCamera, 1);
     G_AddCommand("enddemo", CMD_EndDemo, 0);
+    G_AddCommand("benchtrace", CMD_BenchTrace, 0);
+    G_AddCommand("benchsights", CMD_BenchSights, 0);
+    G_AddCommand("benchblockmap", CMD_BenchBlockMap, 0);
+    G_AddCommand("testreject", CMD_TestReject, 0);
+    G_AddCommand("snapshot", CMD_Snapshot, 0);
+    G_AddCommand("restoresnapshot", CMD_RestoreSnapshot, 0);
+    G_AddCommand("rewind", CMD_Rewind, 0);
 }
 
 //
@@ -32,22 +32,203 @@
 #include "gl_texture.h"
 #include "gl_draw.h"
 #include "r_main.h"
+#include "w_wad.h"
+
+//
+//
+// 2D BATCHING
+//
+// Glyphs and graphics are accumulated into a single vertex list
+// and only drawn when the texture, ortho scale or fill mode changes,
+// when the list fills up, or when the outermost batch ends.
+// Outside of a Draw_BeginBatch/Draw_EndBatch pair every call is
+// flushed right away, just like before.
+//
+//
+
+#define MAXBATCHVERTS   4096
+
+static vtx_t    batchvtx[MAXBATCHVERTS];
+static int      batchcount = 0;
+static int      batchdepth = 0;
+static int      batchgfx = -1;
+static float    batchscale = 1.0f;
+static dboolean batchfill = false;
+
+//
+// Draw_FlushBatch
+//
+
+void Draw_FlushBatch(void) {
+    float scale;
+    dboolean fill = false;
+    dboolean blend;
+    int i;
+
+    if(!batchcount) {
+        return;
+    }
+
+    //
+    // force textured polys when in wireframe mode
+    //
+    if(batchfill && !r_fillmode.value) {
+        dglEnable(GL_TEXTURE_2D);
+        dglPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        r_fillmode.value = 1.0f;
+        fill = true;
+    }
+
+    //
+    // something else may have been bound since the glyphs
+    // were added; every bind clears the other kinds' current
+    // index, so curgfx only matches while the gfx is bound
+    //
+    if(curgfx != batchgfx) {
+        dglBindTexture(GL_TEXTURE_2D, gfxptr[batchgfx]);
+        curgfx = batchgfx;
+        curtexture = cursprite = -1;
+
+        if(devparm || timingdemo) {
+            glBindCalls++;
+        }
+    }
+
+    scale = GL_GetOrthoScale();
+    blend = GL_GetState(GLSTATE_BLEND);
+
+    GL_SetState(GLSTATE_BLEND, 1);
+    GL_SetOrthoScale(batchscale);
+    GL_SetOrtho(0);
+
+    dglSetVertex(batchvtx);
+
+    for(i = 0; i < batchcount; i += 4) {
+        dglTriangle(i + 0, i + 1, i + 2);
+        dglTriangle(i + 0, i + 2, i + 3);
+    }
+
+    dglDrawGeometry(batchcount, batchvtx);
+
+    GL_ResetViewport();
+
+    if(fill) {
+        dglDisable(GL_TEXTURE_2D);
+        dglPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        r_fillmode.value = 0.0f;
+    }
+
+    GL_SetState(GLSTATE_BLEND, blend);
+    GL_SetOrthoScale(scale);
+
+    batchcount = 0;
+}
+
+//
+// Draw_BeginBatch
+//
+
+void Draw_BeginBatch(void) {
+    batchdepth++;
+}
+
+//
+// Draw_EndBatch
+//
+
+void Draw_EndBatch(void) {
+    if(batchdepth <= 0) {
+        return;
+    }
+
+    if(--batchdepth == 0) {
+        Draw_FlushBatch();
+    }
+}
+
+//
+// Draw_BatchTexture
+// Flushes any pending quads that can't share state
+// with the new ones, then binds the new texture
+//
+
+static int Draw_BatchTexture(const char* name, dboolean alpha,
+                             float scale, dboolean fill) {
+    int gfx = W_GetNumForName(name) - g_start;
+
+    if(batchcount && (gfx != batchgfx ||
+                      scale != batchscale || fill != batchfill)) {
+        Draw_FlushBatch();
+    }
+
+    batchgfx = gfx;
+    batchscale = scale;
+    batchfill = fill;
+
+    return GL_BindGfxTexture(name, alpha);
+}
+
+//
+// Draw_BatchQuad
+// Corners are given top-left to bottom-right
+//
+
+static void Draw_BatchQuad(float x1, float y1, float x2, float y2,
+                           float tu1, float tv1, float tu2, float tv2, rcolor c) {
+    vtx_t *v;
+
+    if(batchcount + 4 > MAXBATCHVERTS) {
+        Draw_FlushBatch();
+    }
+
+    v = &batchvtx[batchcount];
+
+    v[0].x  = x1;
+    v[0].y  = y1;
+    v[0].tu = tu1;
+    v[0].tv = tv1;
+    v[1].x  = x2;
+    v[1].y  = y1;
+    v[1].tu = tu2;
+    v[1].tv = tv1;
+    v[2].x  = x2;
+    v[2].y  = y2;
+    v[2].tu = tu2;
+    v[2].tv = tv2;
+    v[3].x  = x1;
+    v[3].y  = y2;
+    v[3].tu = tu1;
+    v[3].tv = tv2;
+
+    v[0].z = v[1].z = v[2].z = v[3].z = 0.0f;
+
+    dglSetVertexColor(v, c, 4);
+    batchcount += 4;
+
+    if(devparm || timingdemo) {
+        vertCount += 4;
+    }
+}
 
 //
 // Draw_GfxImage
 //
 
 void Draw_GfxImage(int x, int y, const char* name, rcolor color, dboolean alpha) {
-    int gfxIdx = GL_BindGfxTexture(name, alpha);
+    int gfxIdx = Draw_BatchTexture(name, alpha, GL_GetOrthoScale(), false);
+    vtx_t v[4];
 
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, DGL_CLAMP);
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, DGL_CLAMP);
 
-    GL_SetState(GLSTATE_BLEND, 1);
-    GL_SetupAndDraw2DQuad((float)x, (float)y,
-                          gfxwidth[gfxIdx], gfxheight[gfxIdx], 0, 1.0f, 0, 1.0f, color, 0);
+    GL_Set2DQuad(v, (float)x, (float)y, gfxwidth[gfxIdx], gfxheight[gfxIdx],
+                 0, 1.0f, 0, 1.0f, color);
 
-    GL_SetState(GLSTATE_BLEND, 0);
+    Draw_BatchQuad(v[0].x, v[0].y, v[3].x, v[3].y, 0, 0, 1.0f, 1.0f, color);
+
+    if(!batchdepth) {
+        Draw_FlushBatch();
+    }
 }
 
 //
@@ -64,6 +245,8 @@ void Draw_Sprite2D(int type, int rot, int frame, int x, int y,
     int offsetx = 0;
     int offsety = 0;
 
+    Draw_FlushBatch();
+
     GL_SetState(GLSTATE_BLEND, 1);
 
     sprdef=&spriteinfo[type];
@@ -106,8 +289,6 @@ void Draw_Sprite2D(int type, int rot, int frame, int x, int y,
 //
 //
 
-static vtx_t vtxstring[MAX_MESSAGE_SIZE];
-
 //
 // Draw_Text
 //
@@ -116,12 +297,10 @@ int Draw_Text(int x, int y, rcolor color, float scale,
               dboolean wrap, const char* string, ...) {
     int c;
     int i;
-    int vi = 0;
     int    col;
     const float size = 0.03125f;
     float fcol, frow;
     int start = 0;
-    dboolean fill = false;
     char msg[MAX_MESSAGE_SIZE];
     va_list    va;
     const int ix = x;
@@ -130,26 +309,12 @@ int Draw_Text(int x, int y, rcolor color, float scale,
     vsprintf(msg, string, va);
     va_end(va);
 
-    GL_SetState(GLSTATE_BLEND, 1);
-
-    if(!r_fillmode.value) {
-        dglEnable(GL_TEXTURE_2D);
-        dglPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        r_fillmode.value = 1.0f;
-        fill = true;
-    }
-
-    GL_BindGfxTexture("SFONT", true);
+    Draw_BatchTexture("SFONT", true, scale, true);
 
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, DGL_CLAMP);
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, DGL_CLAMP);
 
-    GL_SetOrthoScale(scale);
-    GL_SetOrtho(0);
-
-    dglSetVertex(vtxstring);
-
-    for(i = 0, vi = 0; i < dstrlen(msg); i++, vi += 4) {
+    for(i = 0; i < dstrlen(msg); i++) {
         c = toupper(msg[i]);
         if(c == '\t') {
             while(x % 64) {
@@ -178,50 +343,18 @@ int Draw_Text(int x, int y, rcolor color, float scale,
             fcol = (col * size);
             frow = (start >= ST_FONTNUMSET) ? 0.5f : 0.0f;
 
-            vtxstring[vi + 0].x     = (float)x;
-            vtxstring[vi + 0].y     = (float)y;
-            vtxstring[vi + 0].tu    = fcol + 0.0015f;
-            vtxstring[vi + 0].tv    = frow + size;
-            vtxstring[vi + 1].x     = (float)x + ST_FONTWHSIZE;
-            vtxstring[vi + 1].y     = (float)y;
-            vtxstring[vi + 1].tu    = (fcol + size) - 0.0015f;
-            vtxstring[vi + 1].tv    = frow + size;
-            vtxstring[vi + 2].x     = (float)x + ST_FONTWHSIZE;
-            vtxstring[vi + 2].y     = (float)y + ST_FONTWHSIZE;
-            vtxstring[vi + 2].tu    = (fcol + size) - 0.0015f;
-            vtxstring[vi + 2].tv    = frow + 0.5f;
-            vtxstring[vi + 3].x     = (float)x;
-            vtxstring[vi + 3].y     = (float)y + ST_FONTWHSIZE;
-            vtxstring[vi + 3].tu    = fcol + 0.0015f;
-            vtxstring[vi + 3].tv    = frow + 0.5f;
-
-            dglSetVertexColor(vtxstring + vi, color, 4);
-
-            dglTriangle(vi + 0, vi + 1, vi + 2);
-            dglTriangle(vi + 0, vi + 2, vi + 3);
-
-            if(devparm) {
-                vertCount += 4;
-            }
-
-
+            Draw_BatchQuad((float)x, (float)y,
+                           (float)x + ST_FONTWHSIZE, (float)y + ST_FONTWHSIZE,
+                           fcol + 0.0015f, frow + size,
+                           (fcol + size) - 0.0015f, frow + 0.5f, color);
         }
         x += ST_FONTWHSIZE;
     }
 
-    if(vi) {
-        dglDrawGeometry(vi, vtxstring);
-    }
-
-    GL_ResetViewport();
-
-    if(fill) {
-        dglDisable(GL_TEXTURE_2D);
-        dglPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        r_fillmode.value = 0.0f;
+    if(!batchdepth) {
+        Draw_FlushBatch();
     }
 
-    GL_SetState(GLSTATE_BLEND, 0);
     GL_SetOrthoScale(1.0f);
 
     return x;
@@ -400,7 +533,6 @@ int Center_Text(const char* string) {
 int Draw_BigText(int x, int y, rcolor color, const char* string) {
     int c = 0;
     int i = 0;
-    int vi = 0;
     int index = 0;
     float vx1 = 0.0f;
     float vy1 = 0.0f;
@@ -420,7 +552,7 @@ int Draw_BigText(int x, int y, rcolor color, const char* string) {
 
     y += 14;
 
-    pic = GL_BindGfxTexture("SYMBOLS", true);
+    pic = Draw_BatchTexture("SYMBOLS", true, GL_GetOrthoScale(), false);
 
     smbwidth = (float)gfxwidth[pic];
     smbheight = (float)gfxheight[pic];
@@ -428,12 +560,7 @@ int Draw_BigText(int x, int y, rcolor color, const char* string) {
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, DGL_CLAMP);
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, DGL_CLAMP);
 
-    dglSetVertex(vtxstring);
-
-    GL_SetState(GLSTATE_BLEND, 1);
-    GL_SetOrtho(0);
-
-    for(i = 0, vi = 0; i < dstrlen(string); i++, vi += 4) {
+    for(i = 0; i < dstrlen(string); i++) {
         vx1 = (float)x;
         vy1 = (float)y;
 
@@ -508,6 +635,9 @@ int Draw_BigText(int x, int y, rcolor color, const char* string) {
                     index = SM_THERMO + 1;
                     break;
                 default:
+                    if(!batchdepth) {
+                        Draw_FlushBatch();
+                    }
                     return 0;
                 }
             }
@@ -521,43 +651,16 @@ int Draw_BigText(int x, int y, rcolor color, const char* string) {
             ty1 = ((float)symboldata[index].y / smbheight);
             ty2 = ty1 + (((float)symboldata[index].h / smbheight));
 
-            vtxstring[vi + 0].x     = vx1;
-            vtxstring[vi + 0].y     = vy1;
-            vtxstring[vi + 0].tu    = tx1;
-            vtxstring[vi + 0].tv    = ty2;
-            vtxstring[vi + 1].x     = vx2;
-            vtxstring[vi + 1].y     = vy1;
-            vtxstring[vi + 1].tu    = tx2;
-            vtxstring[vi + 1].tv    = ty2;
-            vtxstring[vi + 2].x     = vx2;
-            vtxstring[vi + 2].y     = vy2;
-            vtxstring[vi + 2].tu    = tx2;
-            vtxstring[vi + 2].tv    = ty1;
-            vtxstring[vi + 3].x     = vx1;
-            vtxstring[vi + 3].y     = vy2;
-            vtxstring[vi + 3].tu    = tx1;
-            vtxstring[vi + 3].tv    = ty1;
-
-            dglSetVertexColor(vtxstring + vi, color, 4);
-
-            dglTriangle(vi + 2, vi + 1, vi + 0);
-            dglTriangle(vi + 3, vi + 2, vi + 0);
-
-            if(devparm) {
-                vertCount += 4;
-            }
+            Draw_BatchQuad(vx1, vy2, vx2, vy1, tx1, ty1, tx2, ty2, color);
 
             x += symboldata[index].w;
         }
     }
 
-    if(vi) {
-        dglDrawGeometry(vi, vtxstring);
+    if(!batchdepth) {
+        Draw_FlushBatch();
     }
 
-    GL_ResetViewport();
-    GL_SetState(GLSTATE_BLEND, 0);
-
     return x;
 }
 
@@ -573,6 +676,8 @@ void Draw_Number(int x, int y, int num, int type, rcolor c) {
     int j;
     char str[2];
 
+    Draw_BeginBatch();
+
     for(count = 0, j = 0; count < 16; count++, j++) {
         digits[j] = num % 10;
         nx += symboldata[SM_NUMBERS + digits[j]].w;
@@ -589,9 +694,6 @@ void Draw_Number(int x, int y, int num, int type, rcolor c) {
     }
 
     if(type == 0 || type == 1) {
-        if(count < 0) {
-            return;
-        }
 
         while(count >= 0) {
             sprintf(str, "%i", digits[j]);
@@ -604,10 +706,6 @@ void Draw_Number(int x, int y, int num, int type, rcolor c) {
         }
     }
     else {
-        if(count < 0) {
-            return;
-        }
-
         j = 0;
 
         while(count >= 0) {
@@ -620,6 +718,8 @@ void Draw_Number(int x, int y, int num, int type, rcolor c) {
             j++;
         }
     }
+
+    Draw_EndBatch();
 }
 
 static const symboldata_t confontmap[256] = {
@@ -889,7 +989,6 @@ float Draw_ConsoleText(float x, float y, rcolor color,
                        float scale, const char* string, ...) {
     int c = 0;
     int i = 0;
-    int vi = 0;
     float vx1 = 0.0f;
     float vy1 = 0.0f;
     float vx2 = 0.0f;
@@ -908,7 +1007,7 @@ float Draw_ConsoleText(float x, float y, rcolor color,
     vsprintf(msg, string, va);
     va_end(va);
 
-    pic = GL_BindGfxTexture("CONFONT", true);
+    pic = Draw_BatchTexture("CONFONT", true, GL_GetOrthoScale(), false);
 
     width = (float)gfxwidth[pic];
     height = (float)gfxheight[pic];
@@ -918,12 +1017,7 @@ float Draw_ConsoleText(float x, float y, rcolor color,
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 
-    dglSetVertex(vtxstring);
-
-    GL_SetState(GLSTATE_BLEND, 1);
-    GL_SetOrtho(0);
-
-    for(i = 0, vi = 0; i < dstrlen(msg); i++, vi += 4) {
+    for(i = 0; i < dstrlen(msg); i++) {
         vx1 = x;
         vy1 = y;
 
@@ -941,43 +1035,16 @@ float Draw_ConsoleText(float x, float y, rcolor color,
             ty1 = ((float)confontmap[c].y / height);
             ty2 = ty1 + (((float)confontmap[c].h / height));
 
-            vtxstring[vi + 0].x     = vx1;
-            vtxstring[vi + 0].y     = vy1;
-            vtxstring[vi + 0].tu    = tx1;
-            vtxstring[vi + 0].tv    = ty2;
-            vtxstring[vi + 1].x     = vx2;
-            vtxstring[vi + 1].y     = vy1;
-            vtxstring[vi + 1].tu    = tx2;
-            vtxstring[vi + 1].tv    = ty2;
-            vtxstring[vi + 2].x     = vx2;
-            vtxstring[vi + 2].y     = vy2;
-            vtxstring[vi + 2].tu    = tx2;
-            vtxstring[vi + 2].tv    = ty1;
-            vtxstring[vi + 3].x     = vx1;
-            vtxstring[vi + 3].y     = vy2;
-            vtxstring[vi + 3].tu    = tx1;
-            vtxstring[vi + 3].tv    = ty1;
-
-            dglSetVertexColor(vtxstring + vi, color, 4);
-
-            dglTriangle(vi + 2, vi + 1, vi + 0);
-            dglTriangle(vi + 3, vi + 2, vi + 0);
-
-            if(devparm) {
-                vertCount += 4;
-            }
+            Draw_BatchQuad(vx1, vy2, vx2, vy1, tx1, ty1, tx2, ty2, color);
 
             x += ((float)confontmap[c].w * scale);
         }
     }
 
-    if(vi) {
-        dglDrawGeometry(vi, vtxstring);
+    if(!batchdepth) {
+        Draw_FlushBatch();
     }
 
-    GL_ResetViewport();
-    GL_SetState(GLSTATE_BLEND, 0);
-
     return x;
 }
 
@@ -25,6 +25,9 @@
 
 #include "gl_main.h"
 
+void Draw_BeginBatch(void);
+void Draw_EndBatch(void);
+void Draw_FlushBatch(void);
 void Draw_GfxImage(int x, int y, const char* name,
                    rcolor color, dboolean alpha);
 void Draw_Sprite2D(int type, int rot, int frame, int x, int y,
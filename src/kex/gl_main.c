@@ -37,9 +37,12 @@
 #include "z_zone.h"
 #include "r_main.h"
 #include "gl_texture.h"
+#include "gl_shader.h"
+#include "gl_draw.h"
 #include "con_console.h"
 #include "m_misc.h"
 #include "g_actions.h"
+#include "d_trace.h"
 
 int ViewWindowX = 0;
 int ViewWindowY = 0;
@@ -103,6 +106,9 @@ GL_ARB_texture_non_power_of_two_Define();
 GL_ARB_texture_env_combine_Define();
 GL_EXT_texture_env_combine_Define();
 GL_EXT_texture_filter_anisotropic_Define();
+GL_ARB_shader_objects_Define();
+GL_ARB_vertex_shader_Define();
+GL_ARB_fragment_shader_Define();
 
 //
 // FindExtension
@@ -248,7 +254,9 @@ float GL_GetOrthoScale(void) {
 //
 
 void GL_SwapBuffers(void) {
+    TRACE_BEGIN("GL_SwapBuffers");
     SDL_GL_SwapBuffers();
+    TRACE_END();
 }
 
 //
@@ -399,6 +407,7 @@ void GL_Set2DQuad(vtx_t *v, float x, float y, int width, int height,
 //
 
 void GL_Draw2DQuad(vtx_t *v, dboolean stretch) {
+    Draw_FlushBatch();
     GL_SetOrtho(stretch);
 
     dglSetVertex(v);
@@ -408,7 +417,7 @@ void GL_Draw2DQuad(vtx_t *v, dboolean stretch) {
 
     GL_ResetViewport();
 
-    if(devparm) {
+    if(devparm || timingdemo) {
         vertCount += 4;
     }
 }
@@ -471,6 +480,14 @@ void GL_SetState(int bit, dboolean enable) {
 #undef TOGGLEGLBIT
 }
 
+//
+// GL_GetState
+//
+
+dboolean GL_GetState(int bit) {
+    return (glstate_flag & (1 << bit)) != 0;
+}
+
 //
 // GL_CheckFillMode
 //
@@ -605,7 +622,14 @@ void GL_Init(void) {
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
     SDL_GL_SetAttribute(SDL_GL_BUFFER_SIZE, (int)v_buffersize.value);
     SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, (int)v_depthsize.value);
-    SDL_GL_SetAttribute(SDL_GL_SWAP_CONTROL, (int)v_vsync.value);
+
+    // timedemo frame times would otherwise be capped at the refresh rate
+    if(M_CheckParm("-timedemo")) {
+        SDL_GL_SetAttribute(SDL_GL_SWAP_CONTROL, 0);
+    }
+    else {
+        SDL_GL_SetAttribute(SDL_GL_SWAP_CONTROL, (int)v_vsync.value);
+    }
 
     flags |= SDL_OPENGL;
 
@@ -679,6 +703,9 @@ void GL_Init(void) {
     GL_ARB_texture_env_combine_Init();
     GL_EXT_texture_env_combine_Init();
     GL_EXT_texture_filter_anisotropic_Init();
+    GL_ARB_shader_objects_Init();
+    GL_ARB_vertex_shader_Init();
+    GL_ARB_fragment_shader_Init();
 
     if(!has_GL_ARB_multitexture) {
         CON_Warnf("GL_ARB_multitexture not supported...\n");
@@ -692,6 +719,8 @@ void GL_Init(void) {
         CON_CvarSetValue(r_texturecombiner.name, 0.0f);
     }
 
+    GL_InitShaders();
+
     dglEnableClientState(GL_VERTEX_ARRAY);
     dglEnableClientState(GL_TEXTURE_COORD_ARRAY);
     dglEnableClientState(GL_COLOR_ARRAY);
@@ -93,6 +93,7 @@ void GL_ResetViewport(void);
 void GL_SetOrthoScale(float scale);
 float GL_GetOrthoScale(void);
 void GL_SetState(int bit, dboolean enable);
+dboolean GL_GetState(int bit);
 void GL_SetDefaultCombiner(void);
 void GL_SetColorScale(void);
 void GL_Set2DQuad(vtx_t *v, float x, float y, int width, int height,
@@ -0,0 +1,277 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2012 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION: GLSL world rendering path
+//
+// Replaces the texture combiner setup used by R_RenderWorld with
+// a single program. Sector light, flash color and fog are fed in
+// as uniforms instead of env colors and env texture uploads.
+//
+//-----------------------------------------------------------------------------
+
+#include "doomdef.h"
+#include "doomstat.h"
+#include "gl_main.h"
+#include "gl_shader.h"
+#include "con_console.h"
+#include "i_system.h"
+#include "z_zone.h"
+
+CVAR(r_glsl, 0);
+
+CVAR_EXTERNAL(r_fillmode);
+CVAR_EXTERNAL(r_colorscale);
+
+dboolean gl_has_shaders = false;
+dboolean gl_worldshader = false;
+
+static rhandle worldprogram = 0;
+
+static int u_texture;
+static int u_lightadd;
+static int u_lights;
+static int u_flash;
+static int u_fogmode;
+static int u_colorscale;
+
+static int lastlightlevel = -1;
+
+//
+// World vertex program
+//
+// gl_FogFragCoord is the eye depth, which is what the fixed
+// function pipeline uses for GL_FOG_COORDINATE_SOURCE = FRAGMENT_DEPTH
+//
+
+static const char *worldvertex =
+    "void main() {\n"
+    "    vec4 eye = gl_ModelViewMatrix * gl_Vertex;\n"
+    "    gl_Position = ftransform();\n"
+    "    gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+    "    gl_FrontColor = gl_Color;\n"
+    "    gl_FogFragCoord = abs(eye.z);\n"
+    "}\n";
+
+//
+// World fragment program
+//
+// Mirrors the combiner chain set up by R_RenderWorld:
+// unit 0: texture + sector light (scaled by r_colorscale)
+// unit 1: modulate by vertex color (unless nolights)
+// unit 2: add flash color
+// alpha:  texture alpha * vertex alpha
+// each stage clamps to [0, 1] just like the combiners do
+//
+
+static const char *worldfragment =
+    "uniform sampler2D diffuse;\n"
+    "uniform float lightadd;\n"
+    "uniform float lights;\n"
+    "uniform float colorscale;\n"
+    "uniform vec3 flash;\n"
+    "uniform int fogmode;\n"
+    "void main() {\n"
+    "    vec4 tex = texture2D(diffuse, gl_TexCoord[0].st);\n"
+    "    vec3 color = clamp((tex.rgb + vec3(lightadd)) * colorscale, 0.0, 1.0);\n"
+    "    float fog = 1.0;\n"
+    "    color = mix(color, color * gl_Color.rgb, lights);\n"
+    "    color = clamp(color + flash, 0.0, 1.0);\n"
+    "    if(fogmode == 1) {\n"
+    "        fog = (gl_Fog.end - gl_FogFragCoord) * gl_Fog.scale;\n"
+    "    }\n"
+    "    else if(fogmode == 2) {\n"
+    "        fog = exp(-gl_Fog.density * gl_FogFragCoord);\n"
+    "    }\n"
+    "    color = mix(gl_Fog.color.rgb, color, clamp(fog, 0.0, 1.0));\n"
+    "    gl_FragColor = vec4(color, tex.a * gl_Color.a);\n"
+    "}\n";
+
+//
+// GL_CompileShader
+//
+
+static rhandle GL_CompileShader(int type, const char *source) {
+    rhandle shader;
+    int status = 0;
+
+    shader = dglCreateShaderObjectARB(type);
+    dglShaderSourceARB(shader, 1, &source, NULL);
+    dglCompileShaderARB(shader);
+    dglGetObjectParameterivARB(shader, GL_OBJECT_COMPILE_STATUS_ARB, &status);
+
+    if(!status) {
+        char log[1024];
+
+        dglGetInfoLogARB(shader, sizeof(log), NULL, log);
+        CON_Warnf("GL_CompileShader: %s\n", log);
+        dglDeleteObjectARB(shader);
+        return 0;
+    }
+
+    return shader;
+}
+
+//
+// GL_LinkWorldProgram
+//
+
+static dboolean GL_LinkWorldProgram(void) {
+    rhandle vertex;
+    rhandle fragment;
+    int status = 0;
+
+    vertex = GL_CompileShader(GL_VERTEX_SHADER_ARB, worldvertex);
+    fragment = GL_CompileShader(GL_FRAGMENT_SHADER_ARB, worldfragment);
+
+    if(!vertex || !fragment) {
+        return false;
+    }
+
+    worldprogram = dglCreateProgramObjectARB();
+    dglAttachObjectARB(worldprogram, vertex);
+    dglAttachObjectARB(worldprogram, fragment);
+    dglLinkProgramARB(worldprogram);
+
+    // program keeps the objects alive
+    dglDeleteObjectARB(vertex);
+    dglDeleteObjectARB(fragment);
+
+    dglGetObjectParameterivARB(worldprogram, GL_OBJECT_LINK_STATUS_ARB, &status);
+
+    if(!status) {
+        char log[1024];
+
+        dglGetInfoLogARB(worldprogram, sizeof(log), NULL, log);
+        CON_Warnf("GL_LinkWorldProgram: %s\n", log);
+        dglDeleteObjectARB(worldprogram);
+        worldprogram = 0;
+        return false;
+    }
+
+    u_texture       = dglGetUniformLocationARB(worldprogram, "diffuse");
+    u_lightadd      = dglGetUniformLocationARB(worldprogram, "lightadd");
+    u_lights        = dglGetUniformLocationARB(worldprogram, "lights");
+    u_flash         = dglGetUniformLocationARB(worldprogram, "flash");
+    u_fogmode       = dglGetUniformLocationARB(worldprogram, "fogmode");
+    u_colorscale    = dglGetUniformLocationARB(worldprogram, "colorscale");
+
+    dglUseProgramObjectARB(worldprogram);
+    dglUniform1iARB(u_texture, 0);
+    dglUseProgramObjectARB(0);
+
+    return true;
+}
+
+//
+// GL_InitShaders
+//
+
+void GL_InitShaders(void) {
+    gl_has_shaders = (has_GL_ARB_shader_objects &&
+                      has_GL_ARB_vertex_shader &&
+                      has_GL_ARB_fragment_shader);
+
+    if(!gl_has_shaders) {
+        CON_Warnf("GLSL not supported...\n");
+        return;
+    }
+
+    if(!GL_LinkWorldProgram()) {
+        CON_Warnf("Failed to build world shader, disabling GLSL\n");
+        gl_has_shaders = false;
+    }
+}
+
+//
+// GL_CanUseWorldShader
+//
+
+dboolean GL_CanUseWorldShader(void) {
+    return (gl_has_shaders && r_glsl.value > 0 && r_fillmode.value > 0);
+}
+
+//
+// GL_BindWorldShader
+// fog is the GL_FOG_MODE SetupFog picked, or 0 when fog is off
+//
+
+void GL_BindWorldShader(dboolean lights, rcolor flash, int fog) {
+    float f[4];
+    float scale;
+    int fogmode = 0;
+
+    if(fog == GL_LINEAR) {
+        fogmode = 1;
+    }
+    else if(fog == GL_EXP) {
+        fogmode = 2;
+    }
+
+    switch((int)r_colorscale.value) {
+    case 1:
+        scale = 2.0f;
+        break;
+    case 2:
+        scale = 4.0f;
+        break;
+    default:
+        scale = 1.0f;
+        break;
+    }
+
+    dglGetColorf(flash, f);
+
+    dglUseProgramObjectARB(worldprogram);
+    dglUniform1fARB(u_lights, lights ? 1.0f : 0.0f);
+    dglUniform3fARB(u_flash, f[0], f[1], f[2]);
+    dglUniform1iARB(u_fogmode, fogmode);
+    dglUniform1fARB(u_colorscale, scale);
+
+    lastlightlevel = -1;
+    gl_worldshader = true;
+}
+
+//
+// GL_SetWorldShaderLight
+//
+
+void GL_SetWorldShaderLight(int lightlevel) {
+    if(lastlightlevel == lightlevel) {
+        return;
+    }
+
+    lastlightlevel = lightlevel;
+    dglUniform1fARB(u_lightadd, (float)lightlevel / 255.0f);
+}
+
+//
+// GL_UnbindWorldShader
+//
+
+void GL_UnbindWorldShader(void) {
+    if(!gl_worldshader) {
+        return;
+    }
+
+    dglUseProgramObjectARB(0);
+    gl_worldshader = false;
+}
@@ -0,0 +1,37 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2012 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef __GL_SHADER_H__
+#define __GL_SHADER_H__
+
+#include "gl_main.h"
+
+extern dboolean gl_has_shaders;
+extern dboolean gl_worldshader;     // world program is currently bound
+
+void GL_InitShaders(void);
+dboolean GL_CanUseWorldShader(void);
+void GL_BindWorldShader(dboolean lights, rcolor flash, int fog);
+void GL_SetWorldShaderLight(int lightlevel);
+void GL_UnbindWorldShader(void);
+
+#endif
@@ -194,14 +194,16 @@ void GL_BindWorldTexture(int texnum, int *width, int *height) {
         return;
     }
 
+    // only the last kind bound is really on the unit
     curtexture = texnum;
+    cursprite = curgfx = -1;
 
     // if texture is already in video ram
     if(textureptr[texnum][palettetranslation[texnum]]) {
         dglBindTexture(GL_TEXTURE_2D, textureptr[texnum][palettetranslation[texnum]]);
         dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        if(devparm) {
+        if(devparm || timingdemo) {
             glBindCalls++;
         }
         return;
@@ -234,7 +236,7 @@ void GL_BindWorldTexture(int texnum, int *width, int *height) {
 
     Z_Free(png);
 
-    if(devparm) {
+    if(devparm || timingdemo) {
         glBindCalls++;
     }
 }
@@ -374,11 +376,12 @@ int GL_BindGfxTexture(const char* name, dboolean alpha) {
     }
 
     curgfx = gfxid;
+    curtexture = cursprite = -1;
 
     // if texture is already in video ram
     if(gfxptr[gfxid]) {
         dglBindTexture(GL_TEXTURE_2D, gfxptr[gfxid]);
-        if(devparm) {
+        if(devparm || timingdemo) {
             glBindCalls++;
         }
         return gfxid;
@@ -406,7 +409,7 @@ int GL_BindGfxTexture(const char* name, dboolean alpha) {
     gfxwidth[gfxid] = width;
     gfxheight[gfxid] = height;
 
-    if(devparm) {
+    if(devparm || timingdemo) {
         glBindCalls++;
     }
 
@@ -513,13 +516,14 @@ void GL_BindSpriteTexture(int spritenum, int pal) {
 
     cursprite = spritenum;
     curtrans = pal;
+    curtexture = curgfx = -1;
 
     // if texture is already in video ram
     if(spriteptr[spritenum][pal]) {
         dglBindTexture(GL_TEXTURE_2D, spriteptr[spritenum][pal]);
         dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, DGL_CLAMP);
         dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, DGL_CLAMP);
-        if(devparm) {
+        if(devparm || timingdemo) {
             glBindCalls++;
         }
         return;
@@ -546,7 +550,7 @@ void GL_BindSpriteTexture(int spritenum, int pal) {
     spritewidth[spritenum] = w;
     spriteheight[spritenum] = h;
 
-    if(devparm) {
+    if(devparm || timingdemo) {
         glBindCalls++;
     }
 }
@@ -564,6 +568,7 @@ dtexture GL_ScreenToTexture(void) {
 
     dglGenTextures(1, &id);
     dglBindTexture(GL_TEXTURE_2D, id);
+    GL_ResetTextures();
 
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, DGL_CLAMP);
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, DGL_CLAMP);
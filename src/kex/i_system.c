@@ -31,6 +31,9 @@
 #ifdef _WIN32
 #include <direct.h>
 #include <io.h>
+#else
+#include <sys/time.h>
+#include <time.h>
 #endif
 
 #include <stdarg.h>
@@ -273,6 +276,48 @@ void I_Sleep(unsigned long usecs) {
     SDL_Delay(usecs);
 }
 
+//
+// I_CreateThread
+// Returns NULL if the thread couldn't be started
+//
+
+void* I_CreateThread(int (*func)(void*), void* data) {
+    return SDL_CreateThread(func, data);
+}
+
+//
+// I_WaitThread
+//
+
+void I_WaitThread(void* thread) {
+    SDL_WaitThread((SDL_Thread*)thread, NULL);
+}
+
+//
+// I_CreateSemaphore
+// Returns NULL if the semaphore couldn't be created
+//
+
+void* I_CreateSemaphore(int value) {
+    return SDL_CreateSemaphore(value);
+}
+
+//
+// I_SemaphoreWait
+//
+
+void I_SemaphoreWait(void* sem) {
+    SDL_SemWait((SDL_sem*)sem);
+}
+
+//
+// I_SemaphorePost
+//
+
+void I_SemaphorePost(void* sem) {
+    SDL_SemPost((SDL_sem*)sem);
+}
+
 static int basetime = 0;
 
 //
@@ -464,6 +509,62 @@ int I_GetTimeMS(void) {
     return ticks - basetime;
 }
 
+//
+// I_GetTimeUS
+//
+// High resolution timer in microseconds, used for
+// profiling where SDL_GetTicks is too coarse
+//
+
+uint64 I_GetTimeUS(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+
+    if(!freq.QuadPart) {
+        QueryPerformanceFrequency(&freq);
+    }
+
+    QueryPerformanceCounter(&count);
+    return (uint64)(count.QuadPart * 1000000 / freq.QuadPart);
+#else
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (uint64)tv.tv_sec * 1000000 + tv.tv_usec;
+#endif
+}
+
+//
+// I_GetTimeNS
+//
+// Nanosecond timer for the frame tracer
+//
+
+uint64 I_GetTimeNS(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+
+    if(!freq.QuadPart) {
+        QueryPerformanceFrequency(&freq);
+    }
+
+    QueryPerformanceCounter(&count);
+
+    // split up so the multiply can't overflow
+    return (uint64)((count.QuadPart / freq.QuadPart) * 1000000000 +
+                    ((count.QuadPart % freq.QuadPart) * 1000000000) / freq.QuadPart);
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+    return I_GetTimeUS() * 1000;
+#endif
+}
+
 //
 // I_GetRandomTimeSeed
 //
@@ -56,7 +56,14 @@ extern fixed_t rendertic_frac;
 extern int (*I_GetTime)(void);
 void            I_InitClockRate(void);
 int             I_GetTimeMS(void);
+uint64          I_GetTimeUS(void);
+uint64          I_GetTimeNS(void);
 void            I_Sleep(unsigned long usecs);
+void*           I_CreateThread(int (*func)(void*), void* data);
+void            I_WaitThread(void* thread);
+void*           I_CreateSemaphore(int value);
+void            I_SemaphoreWait(void* sem);
+void            I_SemaphorePost(void* sem);
 dboolean        I_StartDisplay(void);
 void            I_EndDisplay(void);
 fixed_t         I_GetTimeFrac(void);
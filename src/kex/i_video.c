@@ -192,6 +192,11 @@ void I_InitVideo(void) {
 
     uint32 f = SDL_INIT_VIDEO;
 
+    // headless runs only need SDL for its timer
+    if(nodrawparm) {
+        f = SDL_INIT_TIMER;
+    }
+
 #ifdef _DEBUG
     f |= SDL_INIT_NOPARACHUTE;
 #endif
@@ -203,6 +208,10 @@ void I_InitVideo(void) {
         exit(1);
     }
 
+    if(nodrawparm) {
+        return;
+    }
+
     sprintf(title, "Doom64 - Version Date: %s", version_date);
     SDL_WM_SetCaption(title, "Doom64");
 
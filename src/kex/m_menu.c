@@ -5077,6 +5077,8 @@ void M_Drawer(void) {
     //
     // begin drawing all menu items
     //
+    Draw_BeginBatch();
+
     for(i = start; i < max+start; i++) {
         //
         // skip hidden items
@@ -5202,6 +5204,8 @@ void M_Drawer(void) {
         }
     }
 
+    Draw_EndBatch();
+
     //
     // draw password cursor
     //
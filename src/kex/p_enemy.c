@@ -90,58 +90,211 @@ void A_Fall(mobj_t *actor);
 
 
 //
-// P_RecursiveSound
+// SOUND PROPAGATION GRAPH
 //
-// Called by P_NoiseAlert.
-// Recursively traverse adjacent sectors,
-// sound blocking lines cut off traversal.
+// Built once per level by P_BuildSoundGraph: for every sector, the
+// lines leading out of it that have a back side, and the sector on
+// the far side. Line flags (P_ModifyLine) and sector heights
+// (movers) change at runtime, so both are still checked live while
+// flooding; the graph only saves walking one sided lines and
+// looking up sides[] for every edge.
 //
 
+typedef struct {
+    line_t*     line;
+    sector_t*   other;
+} soundedge_t;
+
+static soundedge_t* soundedges;
+static int*         soundedgefirst;     // numsectors+1 offsets
+static sector_t**   soundqueue;
+
 mobj_t* soundtarget;
 
-void P_RecursiveSound(sector_t* sec, int soundblocks) {
-    int        i;
-    line_t*    check;
-    sector_t*    other;
+//
+// P_BuildSoundGraph
+// Called by P_GroupLines once sector line lists exist
+//
+
+void P_BuildSoundGraph(void) {
+    int         i;
+    int         j;
+    int         count;
+    sector_t*   sec;
+    line_t*     check;
+
+    soundedgefirst = Z_Malloc(sizeof(int) * (numsectors + 1), PU_LEVEL, 0);
+    soundqueue = Z_Malloc(sizeof(sector_t*) * numsectors, PU_LEVEL, 0);
+
+    count = 0;
+    for(i = 0, sec = sectors; i < numsectors; i++, sec++) {
+        soundedgefirst[i] = count;
+
+        for(j = 0; j < sec->linecount; j++) {
+            if(sec->lines[j]->sidenum[1] != NO_SIDE_INDEX) {
+                count++;
+            }
+        }
+    }
+
+    soundedgefirst[numsectors] = count;
+    soundedges = Z_Malloc(sizeof(soundedge_t) * (count ? count : 1), PU_LEVEL, 0);
+
+    count = 0;
+    for(i = 0, sec = sectors; i < numsectors; i++, sec++) {
+        for(j = 0; j < sec->linecount; j++) {
+            check = sec->lines[j];
+
+            if(check->sidenum[1] == NO_SIDE_INDEX) {
+                continue;
+            }
+
+            soundedges[count].line = check;
+
+            if(sides[check->sidenum[0]].sector == sec) {
+                soundedges[count].other = sides[check->sidenum[1]].sector;
+            }
+            else {
+                soundedges[count].other = sides[check->sidenum[0]].sector;
+            }
+
+            count++;
+        }
+    }
+}
+
+//
+// P_SoundEdgeOpen
+// Same test as P_LineOpening/openrange > 0,
+// without touching the shared opening globals
+//
+
+static dboolean P_SoundEdgeOpen(line_t* check) {
+    sector_t*   front;
+    sector_t*   back;
+    fixed_t     top;
+    fixed_t     bottom;
+
+    if(!(check->flags & ML_TWOSIDED)) {
+        return false;
+    }
+
+    front = check->frontsector;
+    back = check->backsector;
+
+    top = front->ceilingheight < back->ceilingheight ?
+          front->ceilingheight : back->ceilingheight;
+    bottom = front->floorheight > back->floorheight ?
+             front->floorheight : back->floorheight;
+
+    return (top - bottom > 0);
+}
 
+//
+// P_FloodSound
+// Marks a sector as reached through soundblocks sound blocking
+// lines, unless it was already reached through as few
+//
+
+static dboolean P_FloodSound(sector_t* sec, int soundblocks) {
     // wake up all monsters in this sector
     if(sec->validcount == validcount && sec->soundtraversed <= soundblocks+1) {
-        return;    // already flooded
+        return false;    // already flooded
     }
 
     sec->validcount     = validcount;
     sec->soundtraversed = soundblocks+1;
 
     P_SetTarget(&sec->soundtarget, soundtarget);
+    return true;
+}
 
-    for(i = 0; i < sec->linecount; i++) {
-        check = sec->lines[i];
-        if(!(check->flags & ML_TWOSIDED)) {
-            continue;
-        }
+//
+// P_SpreadSound
+// Drains the queue from head, flooding across open lines
+// that don't block sound. Returns the new queue tail
+//
 
-        P_LineOpening(check);
+static int P_SpreadSound(int head, int tail, int soundblocks) {
+    sector_t*       sec;
+    soundedge_t*    edge;
+    int             i;
+    int             end;
 
-        if(openrange <= 0) {
-            continue;    // closed door
-        }
+    for(; head < tail; head++) {
+        sec = soundqueue[head];
+        end = soundedgefirst[(sec - sectors) + 1];
 
-        if(sides[check->sidenum[0] ].sector == sec) {
-            other = sides[check->sidenum[1]].sector;
-        }
-        else {
-            other = sides[check->sidenum[0]].sector;
-        }
+        for(i = soundedgefirst[sec - sectors]; i < end; i++) {
+            edge = &soundedges[i];
+
+            if(edge->line->flags & ML_SOUNDBLOCK) {
+                continue;
+            }
+
+            if(!P_SoundEdgeOpen(edge->line)) {
+                continue;    // closed door
+            }
 
-        if(check->flags & ML_SOUNDBLOCK) {
-            if(!soundblocks) {
-                P_RecursiveSound(other, 1);
+            if(P_FloodSound(edge->other, soundblocks)) {
+                soundqueue[tail++] = edge->other;
             }
         }
-        else {
-            P_RecursiveSound(other, soundblocks);
+    }
+
+    return tail;
+}
+
+//
+// P_PropagateSound
+//
+// Called by P_NoiseAlert.
+// Breadth first flood through adjacent sectors; sound blocking
+// lines cut off traversal after the first one. The first pass
+// floods everything reachable without crossing one, the second
+// steps over one from there. Every sector ends up with the same
+// soundtraversed/soundtarget as the old recursive walk gave it,
+// and is queued at most once, so the queue never overflows.
+//
+
+static void P_PropagateSound(sector_t* start) {
+    int             head;
+    int             tail;
+    int             reached;
+    int             i;
+    int             end;
+    sector_t*       sec;
+    soundedge_t*    edge;
+
+    tail = 0;
+
+    if(P_FloodSound(start, 0)) {
+        soundqueue[tail++] = start;
+    }
+
+    reached = tail = P_SpreadSound(0, tail, 0);
+
+    // step over a single sound blocking line from
+    // every sector the first pass reached
+    for(head = 0; head < reached; head++) {
+        sec = soundqueue[head];
+        end = soundedgefirst[(sec - sectors) + 1];
+
+        for(i = soundedgefirst[sec - sectors]; i < end; i++) {
+            edge = &soundedges[i];
+
+            if(!(edge->line->flags & ML_SOUNDBLOCK) ||
+                    !P_SoundEdgeOpen(edge->line)) {
+                continue;
+            }
+
+            if(P_FloodSound(edge->other, 1)) {
+                soundqueue[tail++] = edge->other;
+            }
         }
     }
+
+    P_SpreadSound(reached, tail, 1);
 }
 
 
@@ -155,7 +308,7 @@ void P_RecursiveSound(sector_t* sec, int soundblocks) {
 void P_NoiseAlert(mobj_t* target, mobj_t* emmiter) {
     soundtarget = target;
     D_IncValidCount();
-    P_RecursiveSound(emmiter->subsector->sector, 0);
+    P_PropagateSound(emmiter->subsector->sector);
 }
 
 
@@ -49,6 +49,9 @@ result_e T_MovePlane(sector_t* sector, fixed_t speed, fixed_t dest,
     dboolean flag;
     fixed_t lastpos;
 
+    // neighbor extrema depend on sector heights
+    P_InvalidateSectorExtrema(sector);
+
     switch(floorOrCeiling) {
     case 0:
         // FLOOR
@@ -153,7 +156,10 @@ result_e T_MovePlane(sector_t* sector, fixed_t speed, fixed_t dest,
                 return pastdest;
             }
             else {
+                // no P_ChangeSector here, so nothing else
+                // drops sight results through this sector
                 sector->ceilingheight += speed;
+                P_InvalidateSightCache();
             }
             break;
         }
@@ -465,6 +471,8 @@ void T_MoveSplitPlane(splitmove_t *split) {
     dboolean cdone      = false;
     dboolean fdone      = false;
 
+    P_InvalidateSectorExtrema(sector);
+
     if(split->ceildir == -1) {
         lastceilpos = sector->ceilingheight;
 
@@ -40,9 +40,10 @@
 
 // mapblocks are used to check movement
 // against lines and things
-#define MAPBLOCKUNITS    128
+// the cell size is 128 unless the blockmap was rebuilt at load
+#define MAPBLOCKSHIFT    bmapshift
+#define MAPBLOCKUNITS    (1<<(MAPBLOCKSHIFT-FRACBITS))
 #define MAPBLOCKSIZE    (MAPBLOCKUNITS*FRACUNIT)
-#define MAPBLOCKSHIFT    (FRACBITS+7)
 #define MAPBMASK        (MAPBLOCKSIZE-1)
 #define MAPBTOFRAC        (MAPBLOCKSHIFT-FRACBITS)
 
@@ -84,8 +85,23 @@ extern    mobj_t        mobjhead;
 void P_InitThinkers(void);
 void P_AddThinker(thinker_t* thinker);
 void P_RemoveThinker(thinker_t* thinker);
+void P_ResetThinkerClasses(void);
 void P_LinkMobj(mobj_t* mobj);
 void P_UnlinkMobj(mobj_t* mobj);
+void P_ClearMobjSlots(void);
+void P_SetMobjSlotPosition(mobj_t* mobj, subsector_t* ss);
+void P_GroupMobjSlots(void);
+
+// packed per-slot mirrors, see p_tick.c
+extern int      nummobjslots;
+extern mobj_t** mobjslotmobj;
+extern fixed_t* mobjslotx;
+extern fixed_t* mobjsloty;
+extern int*     mobjslotsub;
+extern int*     subsectormobjs;
+extern int*     subsectormobjfirst;
+
+extern int      numdormantmobjs;    // skipped by the last P_RunMobjs
 
 extern angle_t frame_angle;
 extern angle_t frame_pitch;
@@ -171,6 +187,7 @@ mobj_t*     P_SpawnMissile(mobj_t* source, mobj_t* dest, mobjtype_t type,
 // P_ENEMY
 //
 void P_NoiseAlert(mobj_t* target, mobj_t* emmiter);
+void P_BuildSoundGraph(void);
 
 
 //
@@ -193,9 +210,10 @@ typedef struct {
     }            d;
 } intercept_t;
 
+// original fixed limit, lifted only under COMPATF_NOINTERCEPTCAP
 #define MAXINTERCEPTS    128
 
-extern intercept_t    intercepts[MAXINTERCEPTS];
+extern intercept_t*    intercepts;
 extern intercept_t*    intercept_p;
 
 typedef dboolean(*traverser_t)(intercept_t *in);
@@ -246,6 +264,16 @@ dboolean    P_TeleportMove(mobj_t* thing, fixed_t x, fixed_t y);
 void        P_SlideMove(mobj_t* mo);
 dboolean    P_CheckSight(mobj_t* t1, mobj_t* t2);
 void        P_ScanSights(void);
+void        P_ScanSightsThreads(int numthreads, int minjobs);
+void        P_InvalidateSightCache(void);
+void        P_ClearSightCache(void);
+dboolean    P_TraceSight(fixed_t x1, fixed_t y1, fixed_t z,
+                         fixed_t x2, fixed_t y2, fixed_t bottom, fixed_t top);
+
+extern int  sightcachecounts[2];
+extern dboolean sightcheck;
+extern int  sightcheckcounts[2];
+
 dboolean    P_UseLines(player_t* player, dboolean showcontext);
 dboolean    P_ChangeSector(sector_t* sector, dboolean crunch);
 mobj_t*     P_CheckOnMobj(mobj_t *thing);
@@ -269,14 +297,22 @@ void    P_RadiusAttack(mobj_t* spot, mobj_t* source, int damage);
 // P_SETUP
 //
 extern byte*        rejectmatrix;    // for fast sight rejection
-extern short*        blockmaplump;    // offsets in blockmap are from here
-extern short*        blockmap;
+extern int*        blockmaplump;    // offsets in blockmap are from here
+extern int*        blockmap;
 extern int            bmapwidth;
 extern int            bmapheight;    // in mapblocks
+extern int            bmapshift;    // log2 of the cell size, in fixed point
 extern fixed_t        bmaporgx;
 extern fixed_t        bmaporgy;    // origin of block map
 extern mobj_t**        blocklinks;    // for thing chains
 
+void        P_SetBlockMapSize(int units);
+
+//
+// P_REJECT
+//
+void        P_BuildReject(int lumpsize);
+
 
 
 //
@@ -1737,6 +1737,12 @@ dboolean P_ChangeSector(sector_t* sector, dboolean crunch) {
     int         x;
     int         y;
 
+    // heights have just changed; anything crushed below
+    // may trigger specials that look at the neighbors,
+    // and sight results through this sector are stale
+    P_InvalidateSectorExtrema(sector);
+    P_InvalidateSightCache();
+
     nofit = false;
     crushchange = crunch;
 
@@ -343,6 +343,8 @@ void P_UnsetThingPosition(mobj_t* thing) {
         else {
             thing->subsector->sector->thinglist = thing->snext;
         }
+
+        P_SetMobjSlotPosition(thing, NULL);
     }
 
     if(!(thing->flags & MF_NOBLOCKMAP)) {
@@ -399,6 +401,8 @@ P_SetThingPosition(mobj_t* thing) {
         }
 
         sec->thinglist = thing;
+
+        P_SetMobjSlotPosition(thing, ss);
     }
 
 
@@ -453,7 +457,7 @@ P_BlockLinesIterator
  int            y,
  dboolean(*func)(line_t*)) {
     int            offset;
-    short*        list;
+    int*           list;
     line_t*        ld;
 
     if(x<0
@@ -521,9 +525,36 @@ P_BlockThingsIterator
 //
 // INTERCEPT ROUTINES
 //
-intercept_t    intercepts[MAXINTERCEPTS];
+intercept_t*    intercepts = NULL;
 intercept_t*    intercept_p;
 
+static int          maxintercepts = 0;
+static intercept_t* sortintercepts = NULL;
+
+//
+// P_CheckIntercepts
+// Makes room for one more intercept. Returns false if the
+// trace is full, which happens unless COMPATF_NOINTERCEPTCAP is set
+//
+
+static dboolean P_CheckIntercepts(void) {
+    int count = intercept_p - intercepts;
+
+    // [d64] exit out if max intercepts has been hit
+    if(count >= MAXINTERCEPTS && !(compatflags & COMPATF_NOINTERCEPTCAP)) {
+        return false;
+    }
+
+    if(count >= maxintercepts) {
+        maxintercepts = maxintercepts ? maxintercepts * 2 : MAXINTERCEPTS;
+        intercepts = Z_Realloc(intercepts, sizeof(intercept_t) * maxintercepts, PU_STATIC, 0);
+        sortintercepts = Z_Realloc(sortintercepts, sizeof(intercept_t) * maxintercepts, PU_STATIC, 0);
+        intercept_p = intercepts + count;
+    }
+
+    return true;
+}
+
 divline_t     trace;
 dboolean     earlyout;
 int        ptflags;
@@ -577,12 +608,10 @@ PIT_AddLineIntercepts(line_t* ld) {
         return false;    // stop checking
     }
 
-    // [d64] exit out if max intercepts has been hit
-    if((intercept_p - intercepts) >= MAXINTERCEPTS) {
+    if(!P_CheckIntercepts()) {
         return true;
     }
 
-
     intercept_p->frac = frac;
     intercept_p->isaline = true;
     intercept_p->d.line = ld;
@@ -647,8 +676,7 @@ dboolean PIT_AddThingIntercepts(mobj_t* thing) {
         return true;    // behind source
     }
 
-    // [d64] exit out if max intercepts has been hit
-    if((intercept_p - intercepts) >= MAXINTERCEPTS) {
+    if(!P_CheckIntercepts()) {
         return true;
     }
 
@@ -661,6 +689,56 @@ dboolean PIT_AddThingIntercepts(mobj_t* thing) {
 }
 
 
+//
+// P_SortIntercepts
+// Stable merge sort by frac, so intercepts at the same
+// distance keep the order they were found in, as they
+// did with the old repeated closest-first scan
+//
+
+static void P_SortIntercepts(intercept_t* list, intercept_t* temp, int count) {
+    int half;
+    int i;
+    int j;
+    int k;
+
+    if(count < 2) {
+        return;
+    }
+
+    half = count / 2;
+    P_SortIntercepts(list, temp, half);
+    P_SortIntercepts(list + half, temp, count - half);
+
+    // already in order
+    if(list[half - 1].frac <= list[half].frac) {
+        return;
+    }
+
+    dmemcpy(temp, list, sizeof(intercept_t) * count);
+
+    i = 0;
+    j = half;
+    k = 0;
+
+    while(i < half && j < count) {
+        if(temp[j].frac < temp[i].frac) {
+            list[k++] = temp[j++];
+        }
+        else {
+            list[k++] = temp[i++];
+        }
+    }
+
+    while(i < half) {
+        list[k++] = temp[i++];
+    }
+
+    while(j < count) {
+        list[k++] = temp[j++];
+    }
+}
+
 //
 // P_TraverseIntercepts
 // Returns true if the traverser function returns true
@@ -670,46 +748,18 @@ dboolean
 P_TraverseIntercepts
 (traverser_t    func,
  fixed_t    maxfrac) {
-    int            count;
-    fixed_t        dist;
-    intercept_t*    scan;
     intercept_t*    in;
 
-    count = intercept_p - intercepts;
+    P_SortIntercepts(intercepts, sortintercepts, intercept_p - intercepts);
 
-    in = 0;            // shut up compiler warning
-
-    while(count--) {
-        dist = D_MAXINT;
-        for(scan = intercepts ; scan<intercept_p ; scan++) {
-            if(scan->frac < dist) {
-                dist = scan->frac;
-                in = scan;
-            }
-        }
-
-        if(dist > maxfrac) {
+    for(in = intercepts; in < intercept_p; in++) {
+        if(in->frac > maxfrac) {
             return true;    // checked everything in range
         }
 
-#if 0  // UNUSED
-        {
-            // don't check these yet, there may be others inserted
-            in = scan = intercepts;
-            for(scan = intercepts ; scan<intercept_p ; scan++)
-                if(scan->frac > maxfrac) {
-                    *in++ = *scan;
-                }
-            intercept_p = in;
-            return false;
-        }
-#endif
-
         if(!func(in)) {
             return false;    // don't bother going farther
         }
-
-        in->frac = D_MAXINT;
     }
 
     return true;        // everything was traversed
@@ -755,6 +805,7 @@ P_PathTraverse
     int        mapxstep;
     int        mapystep;
     int        count;
+    int        maxcount;
 
     if(r_drawtrace.value) {
         tracedrawer_t* tdrawer;
@@ -837,11 +888,17 @@ P_PathTraverse
 
     // Step through map blocks.
     // Count is present to prevent a round off error
-    // from skipping the break.
+    // from skipping the break. Smaller rebuilt cells
+    // need proportionally more steps for the same trace.
     mapx = xt1;
     mapy = yt1;
+    maxcount = 64;
+
+    if(MAPBLOCKSHIFT < FRACBITS+7) {
+        maxcount <<= (FRACBITS+7) - MAPBLOCKSHIFT;
+    }
 
-    for(count = 0 ; count < 64 ; count++) {
+    for(count = 0 ; count < maxcount ; count++) {
         if(flags & PT_ADDLINES) {
             if(!P_BlockLinesIterator(mapx, mapy,PIT_AddLineIntercepts)) {
                 return false;    // early out
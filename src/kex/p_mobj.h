@@ -256,6 +256,9 @@ typedef struct mobj_s {
     // [kex] mobj reference id
     unsigned int        refcount;
 
+    // index+1 into the packed mobj slot arrays, 0 if unslotted
+    int                 slot;
+
 } mobj_t;
 
 #endif
@@ -0,0 +1,671 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2012 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION: REJECT generation
+//
+// Maps that ship an empty REJECT, or one that only separates
+// unconnected areas, get a real sector-to-sector visibility table
+// built at load time. Sight is flooded outward from each sector
+// through its two-sided lines, and every portal is clipped to the
+// lines that can still pass through the source portal and the
+// portal before it. A pair is rejected only when no straight line
+// can get from one sector to the other, so P_CheckSight would have
+// failed for it anyway. Results are cached on disk by map hash.
+//
+//-----------------------------------------------------------------------------
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "doomdef.h"
+#include "doomstat.h"
+#include "doomdata.h"
+#include "i_system.h"
+#include "z_zone.h"
+#include "w_wad.h"
+#include "m_misc.h"
+#include "p_local.h"
+#include "con_console.h"
+#include "con_cvar.h"
+
+CVAR_EXTERNAL(p_buildreject);
+CVAR_EXTERNAL(p_rejectthreads);
+
+#define REJECTVERSION       2
+
+// P_DivlineSide truncates to whole units, so the engine's sight
+// check can be off by about 1.4 units; keep more slack than that
+#define REJECTEPSILON       2.0
+#define REJECTMAXDEPTH      256
+#define REJECTMAXSTEPS      0x40000
+#define REJECTMAXTHREADS    16
+
+typedef struct {
+    double  x1;
+    double  y1;
+    double  x2;
+    double  y2;
+    int     front;
+    int     back;
+} rportal_t;
+
+// a portal clipped down to the part sight can still reach;
+// n.p - d >= 0 is the side it leads into
+typedef struct {
+    double  x1;
+    double  y1;
+    double  x2;
+    double  y2;
+    double  nx;
+    double  ny;
+    double  d;
+} rwinding_t;
+
+typedef struct {
+    int         thread;
+    int         numthreads;
+    byte*       onpath;         // [numrportals] portals on the current path
+    int         source;
+    byte*       vis;            // [numsectors] row of the source sector
+    int         numvis;
+    int         steps;
+    dboolean    overflow;
+} rejectwork_t;
+
+static rportal_t*   rportals;
+static int          numrportals;
+static int*         rsectorfirst;   // [numsectors + 1] into rsectorportals
+static int*         rsectorportals;
+static int*         rgroup;         // connected area of each sector
+static int*         rgroupsize;
+static byte*        rvis;           // [numsectors * numsectors]
+
+//
+// P_RejectFindGroup
+//
+
+static int P_RejectFindGroup(int sector) {
+    while(rgroup[sector] != sector) {
+        rgroup[sector] = rgroup[rgroup[sector]];
+        sector = rgroup[sector];
+    }
+
+    return sector;
+}
+
+//
+// P_RejectSetup
+// Collects two-sided lines into per-sector portal lists
+// and groups sectors into connected areas
+//
+
+static void P_RejectSetup(void) {
+    line_t* line;
+    int* count;
+    int i;
+
+    rportals = (rportal_t*)Z_Malloc(sizeof(rportal_t) * (numlines + 1), PU_STATIC, 0);
+    rsectorfirst = (int*)Z_Calloc(sizeof(int) * (numsectors + 1), PU_STATIC, 0);
+    rgroup = (int*)Z_Malloc(sizeof(int) * numsectors, PU_STATIC, 0);
+    rgroupsize = (int*)Z_Calloc(sizeof(int) * numsectors, PU_STATIC, 0);
+    numrportals = 0;
+
+    for(i = 0; i < numsectors; i++) {
+        rgroup[i] = i;
+    }
+
+    for(i = 0, line = lines; i < numlines; i++, line++) {
+        rportal_t* p;
+        int g1;
+        int g2;
+
+        if(!line->frontsector || !line->backsector ||
+                line->frontsector == line->backsector) {
+            continue;
+        }
+
+        if(line->v1->x == line->v2->x && line->v1->y == line->v2->y) {
+            continue;
+        }
+
+        p = &rportals[numrportals++];
+        p->x1 = (double)line->v1->x / FRACUNIT;
+        p->y1 = (double)line->v1->y / FRACUNIT;
+        p->x2 = (double)line->v2->x / FRACUNIT;
+        p->y2 = (double)line->v2->y / FRACUNIT;
+        p->front = line->frontsector - sectors;
+        p->back = line->backsector - sectors;
+
+        rsectorfirst[p->front + 1]++;
+        rsectorfirst[p->back + 1]++;
+
+        g1 = P_RejectFindGroup(p->front);
+        g2 = P_RejectFindGroup(p->back);
+
+        if(g1 != g2) {
+            rgroup[g1] = g2;
+        }
+    }
+
+    for(i = 0; i < numsectors; i++) {
+        rgroup[i] = P_RejectFindGroup(i);
+        rgroupsize[rgroup[i]]++;
+    }
+
+    // turn the counts into offsets; a sector's portals
+    // run from rsectorfirst[i] up to rsectorfirst[i + 1]
+    for(i = 1; i <= numsectors; i++) {
+        rsectorfirst[i] += rsectorfirst[i - 1];
+    }
+
+    rsectorportals = (int*)Z_Malloc(sizeof(int) * (rsectorfirst[numsectors] + 1), PU_STATIC, 0);
+    count = (int*)Z_Calloc(sizeof(int) * numsectors, PU_STATIC, 0);
+
+    for(i = 0; i < numrportals; i++) {
+        int front = rportals[i].front;
+        int back = rportals[i].back;
+
+        rsectorportals[rsectorfirst[front] + count[front]++] = i;
+        rsectorportals[rsectorfirst[back] + count[back]++] = i;
+    }
+
+    Z_Free(count);
+}
+
+//
+// P_RejectFree
+//
+
+static void P_RejectFree(void) {
+    Z_Free(rportals);
+    Z_Free(rsectorfirst);
+    Z_Free(rsectorportals);
+    Z_Free(rgroup);
+    Z_Free(rgroupsize);
+}
+
+//
+// P_RejectIsWeak
+// True when the map's REJECT is missing, empty, or
+// rejects nothing beyond unconnected areas
+//
+
+static dboolean P_RejectIsWeak(int lumpsize) {
+    dboolean empty = true;
+    dboolean grouped = true;
+    int i;
+    int j;
+
+    if(lumpsize < (numsectors * numsectors + 7) / 8) {
+        return true;
+    }
+
+    for(i = 0; i < numsectors; i++) {
+        for(j = 0; j < numsectors; j++) {
+            int pnum = i * numsectors + j;
+            dboolean bit = (rejectmatrix[pnum >> 3] & (1 << (pnum & 7))) != 0;
+
+            if(bit) {
+                empty = false;
+            }
+
+            if(bit != (rgroup[i] != rgroup[j])) {
+                grouped = false;
+            }
+
+            if(!empty && !grouped) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+//
+// P_RejectClip
+// Keeps the part of the winding on the front side of the
+// plane, with some slack so grazing lines are never lost
+//
+
+static dboolean P_RejectClip(rwinding_t* w, double nx, double ny, double d) {
+    double s1 = nx * w->x1 + ny * w->y1 - d;
+    double s2 = nx * w->x2 + ny * w->y2 - d;
+    double t;
+    double x;
+    double y;
+
+    if(s1 >= -REJECTEPSILON && s2 >= -REJECTEPSILON) {
+        return true;
+    }
+
+    if(s1 < -REJECTEPSILON && s2 < -REJECTEPSILON) {
+        return false;
+    }
+
+    t = (-REJECTEPSILON - s1) / (s2 - s1);
+    x = w->x1 + (w->x2 - w->x1) * t;
+    y = w->y1 + (w->y2 - w->y1) * t;
+
+    if(s1 < -REJECTEPSILON) {
+        w->x1 = x;
+        w->y1 = y;
+    }
+    else {
+        w->x2 = x;
+        w->y2 = y;
+    }
+
+    return true;
+}
+
+//
+// P_RejectClipSeparator
+// Line e-f runs from an end of the source to an end of the pass
+// portal. If it separates the source's other end o from the pass
+// portal's other end p, every sight line through both portals
+// stays on p's side of it once past the pass portal
+//
+
+static dboolean P_RejectClipSeparator(rwinding_t* w,
+                                      double ex, double ey, double fx, double fy,
+                                      double ox, double oy, double px, double py) {
+    double dx = fx - ex;
+    double dy = fy - ey;
+    double len = sqrt(dx * dx + dy * dy);
+    double nx;
+    double ny;
+    double d;
+    double so;
+    double sp;
+
+    // portals share this vertex
+    if(len < REJECTEPSILON) {
+        return true;
+    }
+
+    nx = -dy / len;
+    ny = dx / len;
+    d = nx * ex + ny * ey;
+    so = nx * ox + ny * oy - d;
+    sp = nx * px + ny * py - d;
+
+    if(so < -REJECTEPSILON && sp > REJECTEPSILON) {
+        return P_RejectClip(w, nx, ny, d);
+    }
+
+    if(so > REJECTEPSILON && sp < -REJECTEPSILON) {
+        return P_RejectClip(w, -nx, -ny, -d);
+    }
+
+    return true;
+}
+
+//
+// P_RejectWinding
+// Winding for a whole portal, facing into sector 'to'
+//
+
+static void P_RejectWinding(rwinding_t* w, rportal_t* p, int to) {
+    double dx = p->x2 - p->x1;
+    double dy = p->y2 - p->y1;
+    double len = sqrt(dx * dx + dy * dy);
+
+    w->x1 = p->x1;
+    w->y1 = p->y1;
+    w->x2 = p->x2;
+    w->y2 = p->y2;
+
+    // the front sector is on the right of v1 -> v2
+    w->nx = dy / len;
+    w->ny = -dx / len;
+
+    if(to != p->front) {
+        w->nx = -w->nx;
+        w->ny = -w->ny;
+    }
+
+    w->d = w->nx * p->x1 + w->ny * p->y1;
+}
+
+//
+// P_RejectFlow
+// Follows sight from the source portal through 'pass'
+// into 'sector' and on through that sector's portals
+//
+
+static void P_RejectFlow(rejectwork_t* work, rwinding_t* src,
+                         rwinding_t* pass, int sector, int depth) {
+    int i;
+
+    if(work->overflow || work->numvis == rgroupsize[rgroup[work->source]]) {
+        return;
+    }
+
+    if(++work->steps > REJECTMAXSTEPS || depth > REJECTMAXDEPTH) {
+        work->overflow = true;
+        return;
+    }
+
+    for(i = rsectorfirst[sector]; i < rsectorfirst[sector + 1]; i++) {
+        int pnum = rsectorportals[i];
+        rportal_t* p = &rportals[pnum];
+        int other = (p->front == sector) ? p->back : p->front;
+        rwinding_t w;
+
+        // a straight line crosses each portal once at most
+        if(work->onpath[pnum]) {
+            continue;
+        }
+
+        P_RejectWinding(&w, p, other);
+
+        // must be ahead of the portal we came through
+        if(!P_RejectClip(&w, pass->nx, pass->ny, pass->d)) {
+            continue;
+        }
+
+        if(src != pass) {
+            if(!P_RejectClipSeparator(&w, src->x1, src->y1, pass->x1, pass->y1,
+                                      src->x2, src->y2, pass->x2, pass->y2) ||
+                    !P_RejectClipSeparator(&w, src->x1, src->y1, pass->x2, pass->y2,
+                                           src->x2, src->y2, pass->x1, pass->y1) ||
+                    !P_RejectClipSeparator(&w, src->x2, src->y2, pass->x1, pass->y1,
+                                           src->x1, src->y1, pass->x2, pass->y2) ||
+                    !P_RejectClipSeparator(&w, src->x2, src->y2, pass->x2, pass->y2,
+                                           src->x1, src->y1, pass->x1, pass->y1)) {
+                continue;
+            }
+        }
+
+        if(!work->vis[other]) {
+            work->vis[other] = 1;
+            work->numvis++;
+        }
+
+        work->onpath[pnum] = 1;
+        P_RejectFlow(work, src, &w, other, depth + 1);
+        work->onpath[pnum] = 0;
+    }
+}
+
+//
+// P_RejectSource
+// Fills in the row of sectors visible from one sector
+//
+
+static void P_RejectSource(rejectwork_t* work, int source) {
+    int i;
+
+    work->source = source;
+    work->vis = rvis + source * numsectors;
+    work->vis[source] = 1;
+    work->numvis = 1;
+    work->steps = 0;
+    work->overflow = false;
+
+    for(i = rsectorfirst[source]; i < rsectorfirst[source + 1]; i++) {
+        int pnum = rsectorportals[i];
+        rportal_t* p = &rportals[pnum];
+        int other = (p->front == source) ? p->back : p->front;
+        rwinding_t w;
+
+        if(!work->vis[other]) {
+            work->vis[other] = 1;
+            work->numvis++;
+        }
+
+        P_RejectWinding(&w, p, other);
+
+        work->onpath[pnum] = 1;
+        P_RejectFlow(work, &w, &w, other, 1);
+        work->onpath[pnum] = 0;
+
+        if(work->overflow) {
+            break;
+        }
+    }
+
+    // too many paths to follow; keep everything it connects to
+    if(work->overflow) {
+        for(i = 0; i < numsectors; i++) {
+            if(rgroup[i] == rgroup[source]) {
+                work->vis[i] = 1;
+            }
+        }
+    }
+}
+
+//
+// P_RejectThread
+//
+
+static int P_RejectThread(void* data) {
+    rejectwork_t* work = (rejectwork_t*)data;
+    int i;
+
+    for(i = work->thread; i < numsectors; i += work->numthreads) {
+        P_RejectSource(work, i);
+    }
+
+    return 0;
+}
+
+//
+// P_RejectHash
+// FNV-1a over the lumps the visibility is built from
+//
+
+static unsigned int P_RejectHash(void) {
+    static const int maplumps[3] = { ML_VERTEXES, ML_SIDEDEFS, ML_LINEDEFS };
+    unsigned int hash = 2166136261u;
+    int i;
+    int j;
+
+    hash = (hash ^ REJECTVERSION) * 16777619u;
+    hash = (hash ^ (unsigned int)numsectors) * 16777619u;
+
+    for(i = 0; i < 3; i++) {
+        byte* data = (byte*)W_GetMapLump(maplumps[i]);
+        int length = W_MapLumpLength(maplumps[i]);
+
+        for(j = 0; j < length; j++) {
+            hash = (hash ^ data[j]) * 16777619u;
+        }
+    }
+
+    return hash;
+}
+
+//
+// P_RejectCacheName
+//
+
+static char* P_RejectCacheName(unsigned int hash) {
+    static char name[256];
+
+#ifdef _WIN32
+    sprintf(name, "reject%08x.rej", hash);
+#else
+    sprintf(name, "%s/.doom64ex/reject%08x.rej", getenv("HOME"), hash);
+#endif
+
+    return name;
+}
+
+//
+// P_RejectReadCache
+//
+
+static dboolean P_RejectReadCache(const char* name, int size) {
+    byte* buffer;
+    int length;
+
+    if((length = M_ReadFile(name, &buffer)) == -1) {
+        return false;
+    }
+
+    if(length != size + 8 || dstrncmp((char*)buffer, "RJ64", 4) ||
+            (buffer[4] | (buffer[5] << 8) | (buffer[6] << 16) | (buffer[7] << 24)) != numsectors) {
+        Z_Free(buffer);
+        return false;
+    }
+
+    dmemcpy(rejectmatrix, buffer + 8, size);
+    Z_Free(buffer);
+
+    return true;
+}
+
+//
+// P_RejectWriteCache
+//
+
+static void P_RejectWriteCache(const char* name, int size) {
+    byte* buffer;
+
+    buffer = (byte*)Z_Malloc(size + 8, PU_STATIC, 0);
+    dmemcpy(buffer, "RJ64", 4);
+    buffer[4] = numsectors & 0xff;
+    buffer[5] = (numsectors >> 8) & 0xff;
+    buffer[6] = (numsectors >> 16) & 0xff;
+    buffer[7] = (numsectors >> 24) & 0xff;
+    dmemcpy(buffer + 8, rejectmatrix, size);
+
+    if(!M_WriteFile(name, buffer, size + 8)) {
+        CON_Warnf("P_BuildReject: couldn't write %s\n", name);
+    }
+
+    Z_Free(buffer);
+}
+
+//
+// P_BuildReject
+// Called from P_LoadReject once the lump has been copied
+// into rejectmatrix, which must hold a full table
+//
+
+void P_BuildReject(int lumpsize) {
+    rejectwork_t work[REJECTMAXTHREADS];
+    void* threads[REJECTMAXTHREADS];
+    int numthreads;
+    int size;
+    int rejected;
+    int i;
+    int j;
+    char* name;
+    uint64 starttime;
+
+    if(!p_buildreject.value || numsectors <= 1) {
+        return;
+    }
+
+    // a built table can change monster behavior, so
+    // demos and netgames always use the lump
+    if(demoplayback || demorecording || netgame) {
+        return;
+    }
+
+    size = (numsectors * numsectors + 7) / 8;
+
+    P_RejectSetup();
+
+    if(!P_RejectIsWeak(lumpsize)) {
+        P_RejectFree();
+        return;
+    }
+
+    name = P_RejectCacheName(P_RejectHash());
+
+    if(P_RejectReadCache(name, size)) {
+        CON_DPrintf("P_BuildReject: loaded %s\n", name);
+        P_RejectFree();
+        return;
+    }
+
+    starttime = I_GetTimeUS();
+
+    numthreads = (int)p_rejectthreads.value;
+
+    if(numthreads < 1) {
+        numthreads = 1;
+    }
+
+    if(numthreads > REJECTMAXTHREADS) {
+        numthreads = REJECTMAXTHREADS;
+    }
+
+    // everything the workers touch is allocated up front;
+    // the zone allocator isn't safe to call from them
+    rvis = (byte*)Z_Calloc(numsectors * numsectors, PU_STATIC, 0);
+
+    for(i = 0; i < numthreads; i++) {
+        work[i].thread = i;
+        work[i].numthreads = numthreads;
+        work[i].onpath = (byte*)Z_Calloc(numrportals + 1, PU_STATIC, 0);
+        threads[i] = NULL;
+    }
+
+    for(i = 1; i < numthreads; i++) {
+        threads[i] = I_CreateThread(P_RejectThread, &work[i]);
+    }
+
+    P_RejectThread(&work[0]);
+
+    for(i = 1; i < numthreads; i++) {
+        if(threads[i]) {
+            I_WaitThread(threads[i]);
+        }
+        else {
+            P_RejectThread(&work[i]);
+        }
+    }
+
+    // reject only when neither side can see the other
+    dmemset(rejectmatrix, 0, size);
+    rejected = 0;
+
+    for(i = 0; i < numsectors; i++) {
+        for(j = 0; j < numsectors; j++) {
+            int pnum = i * numsectors + j;
+
+            if(!rvis[pnum] && !rvis[j * numsectors + i]) {
+                rejectmatrix[pnum >> 3] |= (1 << (pnum & 7));
+                rejected++;
+            }
+        }
+    }
+
+    for(i = 0; i < numthreads; i++) {
+        Z_Free(work[i].onpath);
+    }
+
+    Z_Free(rvis);
+    P_RejectFree();
+
+    CON_DPrintf("P_BuildReject: rejected %i of %i sector pairs in %i ms (%i threads)\n",
+                rejected, numsectors * numsectors,
+                (int)((I_GetTimeUS() - starttime) / 1000), numthreads);
+
+    P_RejectWriteCache(name, size);
+}
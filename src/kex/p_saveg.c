@@ -40,10 +40,15 @@
 #include "p_saveg.h"
 #include "d_englsh.h"
 #include "m_misc.h"
+#include "m_random.h"
+#include "s_sound.h"
+#include "con_console.h"
 #include "doomdef.h" // added just so MSVC would shut up about warning C4761
 
 void G_DoLoadLevel(void);
 
+CVAR_EXTERNAL(p_snapshottics);
+
 //
 // consistency markers
 //
@@ -51,11 +56,18 @@ void G_DoLoadLevel(void);
 #define SAVEGAME_EOF    0x464F45
 #define SAVEGAME_MOBJ   0x4A424F4D
 
-static FILE*    save_stream;
 static byte*    savebuffer;
 
+// everything is archived into memory first;
+// savegames then write it out in one go
+static byte*    savewritebuffer = NULL;
+static int      savewritesize = 0;
+
 static unsigned long save_offset = 0;
 
+// set while archiving an in-memory snapshot
+static dboolean save_snapshot = false;
+
 //
 // P_GetSaveGameName
 //
@@ -88,8 +100,12 @@ static byte saveg_read8(void) {
 }
 
 static void saveg_write8(byte value) {
-    fwrite(&value, 1, 1, save_stream);
-    save_offset++;
+    if(save_offset >= (unsigned long)savewritesize) {
+        savewritesize = savewritesize ? savewritesize << 1 : SAVEGAMESIZE;
+        savewritebuffer = (byte*)Z_Realloc(savewritebuffer, savewritesize, PU_STATIC, 0);
+    }
+
+    savewritebuffer[save_offset++] = value;
 }
 
 static short saveg_read16(void) {
@@ -175,6 +191,31 @@ typedef struct {
 
 static savegmobj_t* savegmobj;
 static int          savegmobjnum;
+static int          savegmobjmax;
+static int*         savegmobjhash;      // open addressed, mobj pointer -> savegmobj slot + 1
+static int          savegmobjhashmask;
+static int          savegmobjhashmax;
+
+//
+// saveg_mobjhash
+//
+
+d_inline static unsigned int saveg_mobjhash(mobj_t* mobj) {
+    return ((unsigned int)((size_t)mobj >> 4) * 2654435761u) & savegmobjhashmask;
+}
+
+//
+// saveg_alloc_mobjtable
+// The table and hash are kept between archives and only grow,
+// since snapshots set them up every few tics
+//
+
+static void saveg_alloc_mobjtable(int count) {
+    if(count > savegmobjmax) {
+        savegmobjmax = count;
+        savegmobj = (savegmobj_t*)Z_Realloc(savegmobj, sizeof(savegmobj_t) * count, PU_STATIC, 0);
+    }
+}
 
 static void saveg_setup_mobjwrite(void) {
     mobj_t* mobj;
@@ -193,7 +234,7 @@ static void saveg_setup_mobjwrite(void) {
     }
 
     // allocate ref table
-    savegmobj = (savegmobj_t*)Z_Alloca(sizeof(savegmobj_t) * savegmobjnum);
+    saveg_alloc_mobjtable(savegmobjnum);
     i = 0;
 
     // store index and mobj
@@ -207,6 +248,31 @@ static void saveg_setup_mobjwrite(void) {
         savegmobj[i].mobj = mobj;
         i++;
     }
+
+    // hash the pointers so each reference is found in constant time
+    savegmobjhashmask = 1;
+
+    while(savegmobjhashmask < savegmobjnum * 2) {
+        savegmobjhashmask <<= 1;
+    }
+
+    if(savegmobjhashmask > savegmobjhashmax) {
+        savegmobjhashmax = savegmobjhashmask;
+        savegmobjhash = (int*)Z_Realloc(savegmobjhash, sizeof(int) * savegmobjhashmask, PU_STATIC, 0);
+    }
+
+    dmemset(savegmobjhash, 0, sizeof(int) * savegmobjhashmask);
+    savegmobjhashmask--;
+
+    for(i = 0; i < savegmobjnum; i++) {
+        unsigned int h = saveg_mobjhash(savegmobj[i].mobj);
+
+        while(savegmobjhash[h]) {
+            h = (h + 1) & savegmobjhashmask;
+        }
+
+        savegmobjhash[h] = i + 1;
+    }
 }
 
 static void saveg_setup_mobjread(void) {
@@ -214,7 +280,7 @@ static void saveg_setup_mobjread(void) {
 
     // get count and allocate table
     savegmobjnum = saveg_read32();
-    savegmobj = (savegmobj_t*)Z_Alloca(sizeof(savegmobj_t) * savegmobjnum);
+    saveg_alloc_mobjtable(savegmobjnum);
 
     // read and add mobjs
     for(i = 0; i < savegmobjnum; i++) {
@@ -224,15 +290,15 @@ static void saveg_setup_mobjread(void) {
 }
 
 static void saveg_write_mobjindex(mobj_t* mobj) {
-    int i;
+    unsigned int h;
 
-    for(i = 0; i < savegmobjnum; i++) {
-        if(savegmobj[i].mobj != mobj) {
-            continue;
+    if(mobj) {
+        for(h = saveg_mobjhash(mobj); savegmobjhash[h]; h = (h + 1) & savegmobjhashmask) {
+            if(savegmobj[savegmobjhash[h] - 1].mobj == mobj) {
+                saveg_write32(savegmobj[savegmobjhash[h] - 1].index);
+                return;
+            }
         }
-
-        saveg_write32(savegmobj[i].index);
-        return;
     }
 
     saveg_write32(0);
@@ -241,14 +307,9 @@ static void saveg_write_mobjindex(mobj_t* mobj) {
 static mobj_t* saveg_read_mobjindex(void) {
     int index = saveg_read32();
 
-    if(index) {
-        int i;
-
-        for(i = 0; i < savegmobjnum; i++) {
-            if(savegmobj[i].index == index) {
-                return savegmobj[i].mobj;
-            }
-        }
+    // indexes are written in table order
+    if(index > 0 && index <= savegmobjnum) {
+        return savegmobj[index - 1].mobj;
     }
 
     return NULL;
@@ -1219,6 +1280,8 @@ static void saveg_write_marker(int marker) {
 
 dboolean P_WriteSaveGame(char* description, int slot) {
     //char name[256];
+    FILE* save_stream;
+    dboolean ok;
 
     // setup game save file
     // sprintf(name, SAVEGAMENAME"%d.dsg", slot);
@@ -1241,10 +1304,12 @@ dboolean P_WriteSaveGame(char* description, int slot) {
 
     saveg_write_marker(SAVEGAME_EOF);
 
+    ok = (fwrite(savewritebuffer, save_offset, 1, save_stream) == 1);
+
     // close out file
     fclose(save_stream);
 
-    return true;
+    return ok;
 }
 
 //
@@ -1490,6 +1555,11 @@ void P_UnArchiveWorld(void) {
         saveg_read_pad();
         light->tag          = saveg_read16();
     }
+
+    // sector tags/flags/heights and line tags/flags were just rewritten
+    P_InitTagLists();
+    P_InitScrollSectors();
+    P_InitSectorNeighbors();
 }
 
 
@@ -1539,6 +1609,7 @@ void P_UnArchiveMobjs(void) {
 
     saveg_setup_mobjread();
     mobjhead.next = mobjhead.prev = &mobjhead;
+    P_ClearMobjSlots();
 
     for(i = 0; i < savegmobjnum; i++) {
         mobj = savegmobj[i].mobj;
@@ -1812,6 +1883,7 @@ void P_UnArchiveSpecials(void) {
     }
 
     thinkercap.prev = thinkercap.next  = &thinkercap;
+    P_ResetThinkerClasses();
 
     while(1) {
         tclass = saveg_read8();
@@ -1883,8 +1955,15 @@ void P_ArchiveMacros(void) {
     saveg_write_pad();
 
     // [kex] 12/26/11 - keep track of disabled macros
+    // snapshots are restored over a live level, so they keep
+    // the id itself to be able to enable a macro again
     for(i = 0; i < macros.macrocount; i++) {
-        saveg_write8(macros.def[i].data[0].id == 0 ? 1 : 0);
+        if(save_snapshot) {
+            saveg_write16(macros.def[i].data[0].id);
+        }
+        else {
+            saveg_write8(macros.def[i].data[0].id == 0 ? 1 : 0);
+        }
     }
 
     if(!macro) {
@@ -1917,7 +1996,10 @@ void P_UnArchiveMacros(void) {
 
     // [kex] 12/26/11 - read tracked info for disabled macros
     for(i = 0; i < macros.macrocount; i++) {
-        if(saveg_read8()) {
+        if(save_snapshot) {
+            macros.def[i].data[0].id = saveg_read16();
+        }
+        else if(saveg_read8()) {
             macros.def[i].data[0].id = 0;
         }
     }
@@ -1943,3 +2025,281 @@ void P_UnArchiveMacros(void) {
 }
 
 
+//------------------------------------------------------------------------
+//
+// In-memory snapshots
+//
+// The same archive as a savegame, kept in memory and restored over
+// the running level instead of reloading the map. The mobj table
+// lookups are constant time and the buffers are reused, so taking
+// one every few tics is cheap enough to leave on for rewinding.
+//
+//------------------------------------------------------------------------
+
+#define SAVEGAME_SNAP   0x50414E53
+#define NUMSNAPSHOTS    16
+
+static savesnapshot_t   snapshotring[NUMSNAPSHOTS];
+static int              snapshothead = 0;
+static int              numsnapshots = 0;
+
+//
+// saveg_clear_level
+// Removes everything a snapshot recreates, the way
+// G_DoLoadLevel leaves it for a savegame
+//
+
+static void saveg_clear_level(void) {
+    mobj_t*     mobj;
+    mobj_t*     next;
+    thinker_t*  th;
+
+    // laser chains hang off their thinkers, which
+    // P_UnArchiveSpecials frees without looking inside
+    for(th = thinkercap.next; th != &thinkercap; th = th->next) {
+        if(th->function.acp1 == (actionf_p1)T_LaserThinker) {
+            laser_t* laser = ((laserthinker_t*)th)->laser;
+
+            while(laser) {
+                laser_t* nextlaser = laser->next;
+
+                Z_Free(laser);
+                laser = nextlaser;
+            }
+
+            ((laserthinker_t*)th)->laser = NULL;
+        }
+    }
+
+    for(mobj = mobjhead.next; mobj != &mobjhead; mobj = next) {
+        next = mobj->next;
+
+        S_RemoveOrigin(mobj);
+
+        // P_RemoveMobj has already unlinked things waiting to be freed
+        if(mobj->mobjfunc != P_SafeRemoveMobj) {
+            P_UnsetThingPosition(mobj);
+        }
+
+        Z_Free(mobj);
+    }
+
+    mobjhead.next = mobjhead.prev = &mobjhead;
+    P_ClearMobjSlots();
+
+    dmemset(activeceilings, 0, sizeof(activeceilings));
+    dmemset(activeplats, 0, sizeof(activeplats));
+    dmemset(buttonlist, 0, sizeof(buttonlist));
+    numactivebuttons = 0;
+
+    bodyqueslot = 0;
+
+    P_InitMacroVars();
+    P_InvalidateSightCache();
+}
+
+//
+// saveg_trim_snapshots
+// Drops ring snapshots that are not older than the
+// current state, after it was loaded from elsewhere
+//
+
+static void saveg_trim_snapshots(void) {
+    while(numsnapshots) {
+        int newest = (snapshothead + NUMSNAPSHOTS - 1) % NUMSNAPSHOTS;
+
+        if(snapshotring[newest].leveltime < leveltime) {
+            break;
+        }
+
+        snapshotring[newest].size = 0;
+        snapshothead = newest;
+        numsnapshots--;
+    }
+}
+
+//
+// P_SaveSnapshot
+//
+
+void P_SaveSnapshot(savesnapshot_t* snap) {
+    byte*   filebuffer = savewritebuffer;
+    int     filesize = savewritesize;
+    int     i;
+
+    savewritebuffer = snap->data;
+    savewritesize = snap->maxsize;
+    save_offset = 0;
+    save_snapshot = true;
+
+    saveg_write32(gamemap);
+    saveg_write32(leveltime);
+    saveg_write32(nextmap);
+    saveg_write32(globalint);
+    saveg_write32(totalkills);
+    saveg_write32(totalitems);
+    saveg_write32(totalsecret);
+
+    for(i = 0; i < NUMPRCLASS; i++) {
+        saveg_write32(rng.seed[i]);
+    }
+
+    saveg_write32(rng.rndindex);
+    saveg_write32(rng.prndindex);
+
+    P_ArchiveMobjs();
+    P_ArchivePlayers();
+    P_ArchiveWorld();
+    P_ArchiveSpecials();
+    P_ArchiveMacros();
+
+    saveg_write_marker(SAVEGAME_SNAP);
+
+    snap->data = savewritebuffer;
+    snap->maxsize = savewritesize;
+    snap->size = save_offset;
+    snap->map = gamemap;
+    snap->leveltime = leveltime;
+
+    savewritebuffer = filebuffer;
+    savewritesize = filesize;
+    save_snapshot = false;
+}
+
+//
+// P_LoadSnapshot
+// Returns false if the snapshot is empty or from another map
+//
+
+dboolean P_LoadSnapshot(savesnapshot_t* snap) {
+    int i;
+
+    if(!snap->size || snap->map != gamemap || gamestate != GS_LEVEL) {
+        return false;
+    }
+
+    saveg_clear_level();
+
+    savebuffer = snap->data;
+    save_offset = 0;
+    save_snapshot = true;
+
+    saveg_read32();     // map
+    leveltime   = saveg_read32();
+    nextmap     = saveg_read32();
+    globalint   = saveg_read32();
+    totalkills  = saveg_read32();
+    totalitems  = saveg_read32();
+    totalsecret = saveg_read32();
+
+    for(i = 0; i < NUMPRCLASS; i++) {
+        rng.seed[i] = saveg_read32();
+    }
+
+    rng.rndindex = saveg_read32();
+    rng.prndindex = saveg_read32();
+
+    P_UnArchiveMobjs();
+    P_UnArchivePlayers();
+    P_UnArchiveWorld();
+    P_UnArchiveSpecials();
+    P_UnArchiveMacros();
+
+    if(!saveg_read_marker(SAVEGAME_SNAP)) {
+        I_Error("P_LoadSnapshot: Bad snapshot");
+    }
+
+    savebuffer = NULL;
+    save_snapshot = false;
+
+    // rewinding from here must not step forward
+    saveg_trim_snapshots();
+
+    return true;
+}
+
+//
+// P_ClearSnapshots
+// Empties the rewind ring; the buffers are kept for reuse
+//
+
+void P_ClearSnapshots(void) {
+    int i;
+
+    for(i = 0; i < NUMSNAPSHOTS; i++) {
+        snapshotring[i].size = 0;
+    }
+
+    snapshothead = 0;
+    numsnapshots = 0;
+}
+
+//
+// P_CaptureSnapshot
+// Called at the end of every tic; takes a rewind snapshot
+// every p_snapshottics tics of single player games
+//
+
+void P_CaptureSnapshot(void) {
+    int interval = (int)p_snapshottics.value;
+
+    if(interval <= 0 || netgame || demoplayback || demorecording) {
+        return;
+    }
+
+    if(leveltime % interval) {
+        return;
+    }
+
+    P_SaveSnapshot(&snapshotring[snapshothead]);
+
+    snapshothead = (snapshothead + 1) % NUMSNAPSHOTS;
+
+    if(numsnapshots < NUMSNAPSHOTS) {
+        numsnapshots++;
+    }
+}
+
+//
+// P_RewindSnapshot
+// Restores the count'th most recent ring snapshot and drops the
+// newer ones, so repeated rewinds keep going back. Returns the
+// number of tics rewound, or -1 if there is nothing to go back to
+//
+
+int P_RewindSnapshot(int count) {
+    int slot;
+    int tics;
+
+    if(count < 1) {
+        return -1;
+    }
+
+    // a snapshot taken at the end of this tic is where the
+    // game already is, so it doesn't count as a step back
+    if(numsnapshots && snapshotring[(snapshothead + NUMSNAPSHOTS - 1) % NUMSNAPSHOTS].leveltime == leveltime) {
+        count++;
+    }
+
+    if(count > numsnapshots) {
+        return -1;
+    }
+
+    slot = (snapshothead + NUMSNAPSHOTS - count) % NUMSNAPSHOTS;
+    tics = leveltime - snapshotring[slot].leveltime;
+
+    if(tics <= 0) {
+        return -1;
+    }
+
+    snapshothead = slot;
+    numsnapshots -= count;
+
+    if(!P_LoadSnapshot(&snapshotring[slot])) {
+        return -1;
+    }
+
+    snapshotring[slot].size = 0;
+
+    return tics;
+}
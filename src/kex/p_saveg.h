@@ -53,4 +53,19 @@ void P_UnArchiveSpecials(void);
 void P_ArchiveMacros(void);
 void P_UnArchiveMacros(void);
 
+// In-memory snapshots of the current level
+typedef struct {
+    byte*   data;
+    int     size;       // bytes in use, 0 when empty
+    int     maxsize;    // bytes allocated
+    int     map;
+    int     leveltime;
+} savesnapshot_t;
+
+void P_SaveSnapshot(savesnapshot_t* snap);
+dboolean P_LoadSnapshot(savesnapshot_t* snap);
+void P_ClearSnapshots(void);
+void P_CaptureSnapshot(void);
+int P_RewindSnapshot(int count);
+
 #endif
@@ -41,6 +41,7 @@
 #include "doomstat.h"
 #include "t_bsp.h"
 #include "p_macros.h"
+#include "p_saveg.h"
 #include "info.h"
 #include "m_misc.h"
 #include "tables.h"
@@ -98,6 +99,13 @@ CVAR(p_sdoubleclick, 0);
 CVAR(p_usecontext, 0);
 CVAR(p_damageindicator, 0);
 CVAR(p_regionmode, 0);
+CVAR(p_buildreject, 1);
+CVAR(p_rejectthreads, 4);
+CVAR(p_sightthreads, 0);
+CVAR(p_snapshottics, 0);
+CVAR(p_groupthinkers, 0);
+CVAR(p_rebuildblockmap, 0);
+CVAR(p_blockmapsize, 128);
 
 //
 // [kex] sky definition stuff
@@ -116,9 +124,10 @@ static skydef_t*    skydefs;
 // Blockmap size.
 int                 bmapwidth;
 int                 bmapheight;     // size in mapblocks
-short*              blockmap;       // int for larger maps
+int                 bmapshift = FRACBITS+7;
+int*                blockmap;       // int for larger maps
 // offsets in blockmap are from here
-short*              blockmaplump;
+int*                blockmaplump;
 // origin of block map
 fixed_t             bmaporgx;
 fixed_t             bmaporgy;
@@ -745,12 +754,23 @@ void P_LoadSideDefs(int lump) {
 //
 
 void P_LoadReject(int lump) {
-    int size = 0;
+    int lumpsize;
+    int size;
+
+    // always allocate a full table; P_CheckSight indexes
+    // it directly and short lumps would be overrun
+    lumpsize = W_MapLumpLength(lump);
+    size = (numsectors * numsectors + 7) / 8;
+
+    if(size < lumpsize) {
+        size = lumpsize;
+    }
 
-    size = W_MapLumpLength(lump);
     rejectmatrix = (byte*)Z_Malloc(size, PU_LEVEL, 0);
     dmemset(rejectmatrix, 0, size);
-    dmemcpy(rejectmatrix, (byte*)W_GetMapLump(lump), size);
+    dmemcpy(rejectmatrix, (byte*)W_GetMapLump(lump), lumpsize);
+
+    P_BuildReject(lumpsize);
 }
 
 static const char *bmaperrormsg;
@@ -763,15 +783,15 @@ static const char *bmaperrormsg;
 static dboolean P_VerifyBlockMap(int count) {
     dboolean isvalid = true;
     int x, y;
-    short *maxoffs = blockmaplump + count;
+    int *maxoffs = blockmaplump + count;
 
     bmaperrormsg = NULL;
 
     for(y = 0; y < bmapheight; ++y) {
         for(x = 0; x < bmapwidth; ++x) {
             int offset;
-            short *list, *tmplist;
-            short *blockoffset;
+            int *list, *tmplist;
+            int *blockoffset;
 
             offset = y * bmapwidth + x;
             blockoffset = blockmaplump + offset + 4;
@@ -825,6 +845,164 @@ static dboolean P_VerifyBlockMap(int count) {
 }
 
 
+//
+// P_BlockMapShift
+// Clamps a cell size in map units to a power of two
+// between 32 and 1024 and returns its fixed point shift
+//
+
+static int P_BlockMapShift(int units) {
+    int shift = 5;
+
+    while(shift < 10 && (2 << shift) <= units) {
+        shift++;
+    }
+
+    return FRACBITS + shift;
+}
+
+//
+// P_BuildBlockMap
+//
+// Builds the blockmap from the linedefs with the given cell shift
+// in the same layout as the lump: a header, one offset per cell
+// and -1 terminated line lists. Offsets are ints, so the size of
+// the map is no longer limited by the lump format. Lines are added
+// in index order, so each list is sorted and the iterators walk
+// lines[] forward.
+//
+
+static void P_BuildBlockMap(int shift) {
+    fixed_t     minx;
+    fixed_t     miny;
+    fixed_t     maxx;
+    fixed_t     maxy;
+    int         ushift;
+    int         numcells;
+    int         total;
+    int*        cursor;
+    int*        list;
+    int         pass;
+    int         i;
+    int         bx;
+    int         by;
+
+    minx = maxx = vertexes[0].x;
+    miny = maxy = vertexes[0].y;
+
+    for(i = 1; i < numvertexes; i++) {
+        minx = MIN(minx, vertexes[i].x);
+        maxx = MAX(maxx, vertexes[i].x);
+        miny = MIN(miny, vertexes[i].y);
+        maxy = MAX(maxy, vertexes[i].y);
+    }
+
+    // same margin as the usual node builders
+    ushift = shift - FRACBITS;
+    minx = F2INT(minx) - 8;
+    miny = F2INT(miny) - 8;
+    maxx = F2INT(maxx);
+    maxy = F2INT(maxy);
+
+    bmapshift = shift;
+    bmaporgx = INT2F(minx);
+    bmaporgy = INT2F(miny);
+    bmapwidth = ((maxx - minx) >> ushift) + 1;
+    bmapheight = ((maxy - miny) >> ushift) + 1;
+    numcells = bmapwidth * bmapheight;
+
+    cursor = (int*)Z_Calloc(sizeof(int) * numcells, PU_STATIC, 0);
+    list = NULL;
+    total = 0;
+
+    // count the lines in each cell, then fill the lists
+    for(pass = 0; pass < 2; pass++) {
+        for(i = 0; i < numlines; i++) {
+            line_t* li = &lines[i];
+            int64   fx1 = (int64)li->v1->x - bmaporgx;
+            int64   fy1 = (int64)li->v1->y - bmaporgy;
+            int64   fx2 = (int64)li->v2->x - bmaporgx;
+            int64   fy2 = (int64)li->v2->y - bmaporgy;
+            int64   x1 = fx1 >> FRACBITS;
+            int64   y1 = fy1 >> FRACBITS;
+            int64   dx = (fx2 >> FRACBITS) - x1;
+            int64   dy = (fy2 >> FRACBITS) - y1;
+            int     bxl = (int)(MIN(fx1, fx2) >> shift);
+            int     bxh = (int)(MAX(fx1, fx2) >> shift);
+            int     byl = (int)(MIN(fy1, fy2) >> shift);
+            int     byh = (int)(MAX(fy1, fy2) >> shift);
+
+            for(by = byl; by <= byh; by++) {
+                for(bx = bxl; bx <= bxh; bx++) {
+                    // diagonal lines only touch the cells
+                    // whose corners are not all on one side.
+                    // the endpoints are truncated to whole units
+                    // for the test, so the cell is padded by a
+                    // unit to keep lines that only clip a corner
+                    if(dx && dy) {
+                        int64 cx1 = ((int64)bx << ushift) - 1 - x1;
+                        int64 cy1 = ((int64)by << ushift) - 1 - y1;
+                        int64 cx2 = cx1 + (1 << ushift) + 2;
+                        int64 cy2 = cy1 + (1 << ushift) + 2;
+                        int64 s1 = cx1 * dy - cy1 * dx;
+                        int64 s2 = cx2 * dy - cy1 * dx;
+                        int64 s3 = cx1 * dy - cy2 * dx;
+                        int64 s4 = cx2 * dy - cy2 * dx;
+
+                        if((s1 > 0 && s2 > 0 && s3 > 0 && s4 > 0) ||
+                                (s1 < 0 && s2 < 0 && s3 < 0 && s4 < 0)) {
+                            continue;
+                        }
+                    }
+
+                    if(pass == 0) {
+                        cursor[by * bmapwidth + bx]++;
+                    }
+                    else {
+                        list[cursor[by * bmapwidth + bx]++] = i;
+                    }
+                }
+            }
+        }
+
+        if(pass == 0) {
+            total = 4 + numcells;
+
+            for(i = 0; i < numcells; i++) {
+                total += cursor[i] + 1;
+            }
+
+            blockmaplump = (int*)Z_Malloc(sizeof(int) * total, PU_LEVEL, NULL);
+            blockmap = blockmaplump + 4;
+            list = blockmaplump;
+
+            blockmaplump[0] = minx;
+            blockmaplump[1] = miny;
+            blockmaplump[2] = bmapwidth;
+            blockmaplump[3] = bmapheight;
+
+            total = 4 + numcells;
+
+            for(i = 0; i < numcells; i++) {
+                blockmap[i] = total;
+                total += cursor[i] + 1;
+                cursor[i] = blockmap[i];
+            }
+        }
+    }
+
+    for(i = 0; i < numcells; i++) {
+        list[cursor[i]] = -1;
+    }
+
+    Z_Free(cursor);
+
+    // clear out mobj chains
+    total = sizeof(*blocklinks) * numcells;
+    blocklinks = Z_Malloc(total, PU_LEVEL, 0);
+    dmemset(blocklinks, 0, total);
+}
+
 //
 // P_LoadBlockMap
 //
@@ -832,26 +1010,47 @@ static dboolean P_VerifyBlockMap(int count) {
 void P_LoadBlockMap(int lump) {
     int         i;
     int         count;
-    void*       mapdata;
+    short*      mapdata;
     size_t      len;
 
-    mapdata = W_GetMapLump(lump);
+    // rebuilt blockmaps change the order lines are checked in,
+    // so demos and netgames always use the lump
+    if(p_rebuildblockmap.value && !demoplayback && !demorecording && !netgame) {
+        P_BuildBlockMap(P_BlockMapShift((int)p_blockmapsize.value));
+        return;
+    }
+
+    mapdata = (short*)W_GetMapLump(lump);
     len = W_MapLumpLength(lump);
+    count = len / 2;
+
+    if(count < 4) {
+        I_Error("P_LoadBlockMap: Bad blockmap - lump too small");
+    }
 
     //
     // GhostlyDeath <10/3/11> -- Reallocate and copy since
     // W_GetMapLump() doesn't quite work like we want it to on 64-bit
     // it works, just the way it is laid out
     //
-    blockmaplump = Z_Malloc(len, PU_LEVEL, NULL);
-    memmove(blockmaplump, mapdata, len);
+    // Widen to ints on the way; offsets and line numbers are
+    // read unsigned so lumps past 32k entries still work
+    //
+    blockmaplump = Z_Malloc(sizeof(int) * count, PU_LEVEL, NULL);
     blockmap = blockmaplump + 4;
-    count = len / 2;
 
     for(i = 0; i < count; i++) {
-        blockmaplump[i] = SHORT(blockmaplump[i]);
+        unsigned short v = (unsigned short)SHORT(mapdata[i]);
+
+        if(i < 4) {
+            blockmaplump[i] = (short)v;
+        }
+        else {
+            blockmaplump[i] = (v == 0xffff) ? -1 : v;
+        }
     }
 
+    bmapshift = FRACBITS+7;
     bmaporgx = INT2F(blockmaplump[0]);
     bmaporgy = INT2F(blockmaplump[1]);
     bmapwidth = blockmaplump[2];
@@ -867,6 +1066,85 @@ void P_LoadBlockMap(int lump) {
     dmemset(blocklinks, 0, count);
 }
 
+//
+// P_SetBlockBoxes
+// Finds the blocks each sector's lines can reach,
+// for moving sectors to check things against
+//
+
+static void P_SetBlockBoxes(void) {
+    fixed_t     bbox[4];
+    int         block;
+    int         i;
+    int         j;
+    sector_t*   sector;
+
+    for(i = 0, sector = sectors; i < numsectors; i++, sector++) {
+        M_ClearBox(bbox);
+
+        for(j = 0; j < sector->linecount; j++) {
+            M_AddToBox(bbox, sector->lines[j]->v1->x, sector->lines[j]->v1->y);
+            M_AddToBox(bbox, sector->lines[j]->v2->x, sector->lines[j]->v2->y);
+        }
+
+        // adjust bounding box to map blocks
+        block = (bbox[BOXTOP]-bmaporgy+MAXRADIUS)>>MAPBLOCKSHIFT;
+        block = block >= bmapheight ? bmapheight-1 : block;
+        sector->blockbox[BOXTOP]=block;
+
+        block = (bbox[BOXBOTTOM]-bmaporgy-MAXRADIUS)>>MAPBLOCKSHIFT;
+        block = block < 0 ? 0 : block;
+        sector->blockbox[BOXBOTTOM]=block;
+
+        block = (bbox[BOXRIGHT]-bmaporgx+MAXRADIUS)>>MAPBLOCKSHIFT;
+        block = block >= bmapwidth ? bmapwidth-1 : block;
+        sector->blockbox[BOXRIGHT]=block;
+
+        block = (bbox[BOXLEFT]-bmaporgx-MAXRADIUS)>>MAPBLOCKSHIFT;
+        block = block < 0 ? 0 : block;
+        sector->blockbox[BOXLEFT]=block;
+    }
+}
+
+//
+// P_SetBlockMapSize
+// Rebuilds the current level's blockmap with a new cell size
+// and relinks every thing into it. A size of 0 goes back to
+// the blockmap the level was loaded with. Things waiting for
+// P_SafeRemoveMobj are already unlinked and are left alone.
+//
+
+void P_SetBlockMapSize(int units) {
+    mobj_t* mo;
+
+    for(mo = mobjhead.next; mo != &mobjhead; mo = mo->next) {
+        if(mo->mobjfunc != P_SafeRemoveMobj) {
+            P_UnsetThingPosition(mo);
+        }
+    }
+
+    // nothing points into the old tables once every thing is unlinked
+    Z_Free(blockmaplump);
+    Z_Free(blocklinks);
+
+    if(units <= 0) {
+        W_CacheMapLump(gamemap);
+        P_LoadBlockMap(ML_BLOCKMAP);
+        W_FreeMapLump();
+    }
+    else {
+        P_BuildBlockMap(P_BlockMapShift(units));
+    }
+
+    P_SetBlockBoxes();
+
+    for(mo = mobjhead.next; mo != &mobjhead; mo = mo->next) {
+        if(mo->mobjfunc != P_SafeRemoveMobj) {
+            P_SetThingPosition(mo);
+        }
+    }
+}
+
 
 
 //
@@ -885,7 +1163,6 @@ void P_GroupLines(void) {
     subsector_t*        ss;
     seg_t*              seg;
     fixed_t             bbox[4];
-    int                 block;
 
     // look up sector number for each subsector
     ss = subsectors;
@@ -937,25 +1214,10 @@ void P_GroupLines(void) {
         // set the degenmobj_t to the middle of the bounding box
         sector->soundorg.x = (bbox[BOXRIGHT]+bbox[BOXLEFT])/2;
         sector->soundorg.y = (bbox[BOXTOP]+bbox[BOXBOTTOM])/2;
-
-        // adjust bounding box to map blocks
-        block = (bbox[BOXTOP]-bmaporgy+MAXRADIUS)>>MAPBLOCKSHIFT;
-        block = block >= bmapheight ? bmapheight-1 : block;
-        sector->blockbox[BOXTOP]=block;
-
-        block = (bbox[BOXBOTTOM]-bmaporgy-MAXRADIUS)>>MAPBLOCKSHIFT;
-        block = block < 0 ? 0 : block;
-        sector->blockbox[BOXBOTTOM]=block;
-
-        block = (bbox[BOXRIGHT]-bmaporgx+MAXRADIUS)>>MAPBLOCKSHIFT;
-        block = block >= bmapwidth ? bmapwidth-1 : block;
-        sector->blockbox[BOXRIGHT]=block;
-
-        block = (bbox[BOXLEFT]-bmaporgx-MAXRADIUS)>>MAPBLOCKSHIFT;
-        block = block < 0 ? 0 : block;
-        sector->blockbox[BOXLEFT]=block;
     }
 
+    P_SetBlockBoxes();
+    P_BuildSoundGraph();
 }
 
 //
@@ -991,6 +1253,8 @@ void P_SetupSky(void) {
     if(sky->flags & SKF_FIRE) {
         R_InitFire();
     }
+
+    R_InitSkyDomes();
 }
 
 //
@@ -1047,6 +1311,8 @@ void P_SetupLevel(int map, int playermask, skill_t skill) {
     M_ClearRandom();
 
     P_InitThinkers();
+    P_ClearSightCache();
+    P_ClearSnapshots();
 
     // [kex] 12/26/11 - don't reset leveltime when loading a savegame
     if(gameaction != ga_loadgame) {
@@ -1067,11 +1333,14 @@ void P_SetupLevel(int map, int playermask, skill_t skill) {
     P_LoadSubsectors(ML_SSECTORS);
     P_LoadBlockMap(ML_BLOCKMAP);
     P_LoadNodes(ML_NODES);
+    R_BuildPointGrid();
     P_LoadSegs(ML_SEGS);
     P_LoadLeafs(ML_LEAFS);
     P_LoadReject(ML_REJECT);
     P_LoadLights(ML_LIGHTS);
     P_GroupLines();
+    P_InitTagLists();
+    P_InitSectorNeighbors();
     P_LoadThings(ML_THINGS);
     W_FreeMapLump();
 
@@ -1484,5 +1753,12 @@ void P_RegisterCvars(void) {
     CON_CvarRegister(&p_usecontext);
     CON_CvarRegister(&p_damageindicator);
     CON_CvarRegister(&p_regionmode);
+    CON_CvarRegister(&p_buildreject);
+    CON_CvarRegister(&p_rejectthreads);
+    CON_CvarRegister(&p_sightthreads);
+    CON_CvarRegister(&p_snapshottics);
+    CON_CvarRegister(&p_groupthinkers);
+    CON_CvarRegister(&p_rebuildblockmap);
+    CON_CvarRegister(&p_blockmapsize);
 }
 
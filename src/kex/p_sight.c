@@ -32,19 +32,106 @@
 #include "i_system.h"
 #include "p_local.h"
 #include "doomstat.h"
+#include "z_zone.h"
+#include "con_console.h"
+
+CVAR_EXTERNAL(p_sightthreads);
 
 //
 // P_CheckSight
 //
-fixed_t     sightzstart;        // eye z of looker
-fixed_t     topslope;
-fixed_t     bottomslope;        // slopes to top and bottom of target
+fixed_t     topslope;           // also used by the aiming code in p_map.c
+fixed_t     bottomslope;
+
+//
+// A sight trace carries everything P_CrossBSPNode reads besides the
+// map itself, so P_ScanSights can run several at once.
+// Only the main thread may use validcount to skip lines it has
+// already checked; workers stamp lines in their own linevalid
+// array instead. Checking a line twice gives the same answer.
+//
 
-divline_t   strace;             // from t1 to t2
-fixed_t     t2x;
-fixed_t     t2y;
+typedef struct {
+    fixed_t     zstart;         // eye z of looker
+    fixed_t     top;
+    fixed_t     bottom;         // slopes to top and bottom of target
+    divline_t   trace;          // from t1 to t2
+    fixed_t     x2;
+    fixed_t     y2;
+    dboolean    usevalid;
+    int*        linevalid;      // [numlines], used over validcount if set
+    int         linestamp;
+} sighttrace_t;
 
 int         sightcounts[2];
+int         sightcachecounts[2];    // hits, misses
+
+//
+// SIGHT CACHE
+// Remembers P_CrossBSPNode results for the current tic, keyed on
+// every input the traversal reads: the trace endpoints, the eye
+// height and the starting slopes. The only other input is sector
+// heights, so the table is flushed whenever leveltime advances
+// and whenever a mover changes a floor or ceiling.
+//
+
+#define SIGHTCACHESIZE  512
+
+typedef struct {
+    int         stamp;
+    fixed_t     x1;
+    fixed_t     y1;
+    fixed_t     x2;
+    fixed_t     y2;
+    fixed_t     zstart;
+    fixed_t     top;
+    fixed_t     bottom;
+    dboolean    result;
+} sightcache_t;
+
+static sightcache_t sightcache[SIGHTCACHESIZE];
+static int          sightstamp = 1;
+static int          sightstamptime = -1;
+
+//
+// P_InvalidateSightCache
+//
+
+void P_InvalidateSightCache(void) {
+    sightstamp++;
+}
+
+//
+// P_ClearSightCache
+//
+
+static int sightvalidgen = 0;
+
+void P_ClearSightCache(void) {
+    sightvalidgen++;    // new level; linevalid arrays must be cleared
+    P_InvalidateSightCache();
+    sightcachecounts[0] = sightcachecounts[1] = 0;
+}
+
+//
+// P_SightCacheSlot
+//
+
+static sightcache_t* P_SightCacheSlot(sighttrace_t* st) {
+    unsigned int hash;
+
+    hash  = (unsigned int)st->trace.x * 0x9E3779B1u;
+    hash ^= (unsigned int)st->trace.y * 0x85EBCA6Bu;
+    hash ^= (unsigned int)st->x2 * 0xC2B2AE35u;
+    hash ^= (unsigned int)st->y2 * 0x27D4EB2Fu;
+    hash ^= (unsigned int)st->zstart * 0x165667B1u;
+    hash ^= (unsigned int)st->top;
+    hash ^= (hash >> 15);
+    hash *= 0x2C1B3C6Du;
+    hash ^= (hash >> 16);
+
+    return &sightcache[hash & (SIGHTCACHESIZE - 1)];
+}
 
 
 //
@@ -128,10 +215,10 @@ fixed_t P_InterceptVector2(divline_t* v2, divline_t* v1) {
 
 //
 // P_CrossSubsector
-// Returns true if strace crosses the given subsector successfully.
+// Returns true if the trace crosses the given subsector successfully.
 //
 
-dboolean P_CrossSubsector(int num) {
+static dboolean P_CrossSubsector(sighttrace_t* st, int num) {
     seg_t*          seg;
     line_t*         line;
     int             s1;
@@ -168,16 +255,27 @@ dboolean P_CrossSubsector(int num) {
         }
 
         // allready checked other side?
-        if(line->validcount == validcount) {
-            continue;
+        if(st->linevalid) {
+            int* valid = &st->linevalid[line - lines];
+
+            if(*valid == st->linestamp) {
+                continue;
+            }
+
+            *valid = st->linestamp;
         }
+        else if(st->usevalid) {
+            if(line->validcount == validcount) {
+                continue;
+            }
 
-        line->validcount = validcount;
+            line->validcount = validcount;
+        }
 
         v1 = line->v1;
         v2 = line->v2;
-        s1 = P_DivlineSide(v1->x,v1->y, &strace);
-        s2 = P_DivlineSide(v2->x, v2->y, &strace);
+        s1 = P_DivlineSide(v1->x,v1->y, &st->trace);
+        s2 = P_DivlineSide(v2->x, v2->y, &st->trace);
 
         // line isn't crossed?
         if(s1 == s2) {
@@ -188,8 +286,8 @@ dboolean P_CrossSubsector(int num) {
         divl.y = v1->y;
         divl.dx = v2->x - v1->x;
         divl.dy = v2->y - v1->y;
-        s1 = P_DivlineSide(strace.x, strace.y, &divl);
-        s2 = P_DivlineSide(t2x, t2y, &divl);
+        s1 = P_DivlineSide(st->trace.x, st->trace.y, &divl);
+        s2 = P_DivlineSide(st->x2, st->y2, &divl);
 
         // line isn't crossed?
         if(s1 == s2) {
@@ -234,23 +332,23 @@ dboolean P_CrossSubsector(int num) {
             return false;    // stop
         }
 
-        frac = P_InterceptVector2(&strace, &divl);
+        frac = P_InterceptVector2(&st->trace, &divl);
 
         if(front->floorheight != back->floorheight) {
-            slope = FixedDiv(openbottom - sightzstart , frac);
-            if(slope > bottomslope) {
-                bottomslope = slope;
+            slope = FixedDiv(openbottom - st->zstart , frac);
+            if(slope > st->bottom) {
+                st->bottom = slope;
             }
         }
 
         if(front->ceilingheight != back->ceilingheight) {
-            slope = FixedDiv(opentop - sightzstart , frac);
-            if(slope < topslope) {
-                topslope = slope;
+            slope = FixedDiv(opentop - st->zstart , frac);
+            if(slope < st->top) {
+                st->top = slope;
             }
         }
 
-        if(topslope <= bottomslope) {
+        if(st->top <= st->bottom) {
             return false;    // stop
         }
     }
@@ -263,43 +361,118 @@ dboolean P_CrossSubsector(int num) {
 
 //
 // P_CrossBSPNode
-// Returns true if strace crosses the given node successfully.
+// Returns true if the trace crosses the given node successfully.
 //
 
-dboolean P_CrossBSPNode(int bspnum) {
+static dboolean P_CrossBSPNode(sighttrace_t* st, int bspnum) {
     node_t* bsp;
     int     side;
 
     if(bspnum & NF_SUBSECTOR) {
         if(bspnum == -1) {
-            return P_CrossSubsector(0);
+            return P_CrossSubsector(st, 0);
         }
         else {
-            return P_CrossSubsector(bspnum&(~NF_SUBSECTOR));
+            return P_CrossSubsector(st, bspnum&(~NF_SUBSECTOR));
         }
     }
 
     bsp = &nodes[bspnum];
 
     // decide which side the start point is on
-    side = P_DivlineSide(strace.x, strace.y, (divline_t *)bsp);
+    side = P_DivlineSide(st->trace.x, st->trace.y, (divline_t *)bsp);
     if(side == 2) {
         side = 0;    // an "on" should cross both sides
     }
 
     // cross the starting side
-    if(!P_CrossBSPNode(bsp->children[side])) {
+    if(!P_CrossBSPNode(st, bsp->children[side])) {
         return false;
     }
 
     // the partition plane is crossed here
-    if(side == P_DivlineSide(t2x, t2y,(divline_t *)bsp)) {
+    if(side == P_DivlineSide(st->x2, st->y2,(divline_t *)bsp)) {
         // the line doesn't touch the other side
         return true;
     }
 
     // cross the ending side
-    return P_CrossBSPNode(bsp->children[side^1]);
+    return P_CrossBSPNode(st, bsp->children[side^1]);
+}
+
+//
+// P_SightRejected
+//
+
+d_inline
+static dboolean P_SightRejected(mobj_t* t1, mobj_t* t2) {
+    int pnum;
+
+    // Determine subsector entries in REJECT table.
+    pnum = (t1->subsector->sector - sectors) * numsectors +
+           (t2->subsector->sector - sectors);
+
+    return (rejectmatrix[pnum >> 3] & (1 << (pnum & 7))) != 0;
+}
+
+//
+// P_SetSightTrace
+// Look from eyes of t1 to any part of t2
+//
+
+static void P_SetSightTrace(sighttrace_t* st, mobj_t* t1, mobj_t* t2) {
+    st->zstart = t1->z + t1->height - (t1->height>>2);
+    st->top = (t2->z+t2->height) - st->zstart;
+    st->bottom = (t2->z) - st->zstart;
+
+    st->trace.x = t1->x;
+    st->trace.y = t1->y;
+    st->x2 = t2->x;
+    st->y2 = t2->y;
+    st->trace.dx = t2->x - t1->x;
+    st->trace.dy = t2->y - t1->y;
+    st->linevalid = NULL;
+}
+
+//
+// P_LookupSightCache
+// Returns the slot for the trace, and whether it already
+// holds the answer. Main thread only.
+//
+
+static sightcache_t* P_LookupSightCache(sighttrace_t* st, dboolean* hit) {
+    sightcache_t* cache;
+
+    if(leveltime != sightstamptime) {
+        sightstamptime = leveltime;
+        P_InvalidateSightCache();
+    }
+
+    cache = P_SightCacheSlot(st);
+
+    *hit = (cache->stamp == sightstamp &&
+            cache->x1 == st->trace.x && cache->y1 == st->trace.y &&
+            cache->x2 == st->x2 && cache->y2 == st->y2 &&
+            cache->zstart == st->zstart &&
+            cache->top == st->top && cache->bottom == st->bottom);
+
+    if(*hit) {
+        sightcachecounts[0]++;
+        return cache;
+    }
+
+    sightcachecounts[1]++;
+
+    cache->stamp = sightstamp;
+    cache->x1 = st->trace.x;
+    cache->y1 = st->trace.y;
+    cache->x2 = st->x2;
+    cache->y2 = st->y2;
+    cache->zstart = st->zstart;
+    cache->top = st->top;
+    cache->bottom = st->bottom;
+
+    return cache;
 }
 
 
@@ -310,23 +483,12 @@ dboolean P_CrossBSPNode(int bspnum) {
 //
 
 dboolean P_CheckSight(mobj_t* t1, mobj_t* t2) {
-    int     s1;
-    int     s2;
-    int     pnum;
-    int     bytenum;
-    int     bitnum;
+    sighttrace_t    st;
+    sightcache_t*   cache;
+    dboolean        hit;
 
     // First check for trivial rejection.
-
-    // Determine subsector entries in REJECT table.
-    s1 = (t1->subsector->sector - sectors);
-    s2 = (t2->subsector->sector - sectors);
-    pnum = s1*numsectors + s2;
-    bytenum = pnum>>3;
-    bitnum = 1 << (pnum&7);
-
-    // Check in REJECT table.
-    if(rejectmatrix[bytenum]&bitnum) {
+    if(P_SightRejected(t1, t2)) {
         sightcounts[0]++;
 
         // can't possibly be connected
@@ -334,36 +496,363 @@ dboolean P_CheckSight(mobj_t* t1, mobj_t* t2) {
     }
 
     // An unobstructed LOS is possible.
-    // Now look from eyes of t1 to any part of t2.
     sightcounts[1]++;
 
-    D_IncValidCount();
+    P_SetSightTrace(&st, t1, t2);
+    cache = P_LookupSightCache(&st, &hit);
 
-    sightzstart = t1->z + t1->height - (t1->height>>2);
-    topslope = (t2->z+t2->height) - sightzstart;
-    bottomslope = (t2->z) - sightzstart;
+    if(hit) {
+        return cache->result;
+    }
 
-    strace.x = t1->x;
-    strace.y = t1->y;
-    t2x = t2->x;
-    t2y = t2->y;
-    strace.dx = t2->x - t1->x;
-    strace.dy = t2->y - t1->y;
+    D_IncValidCount();
+    st.usevalid = true;
 
     // the head node is the last node output
-    return P_CrossBSPNode(numnodes-1);
+    cache->result = P_CrossBSPNode(&st, numnodes-1);
+    return cache->result;
 }
 
 //
-// P_ScanSights
-// Optimal mobj sight checking that check sights
-// in main tick loop rather from multiple
-// mobj action routines
+// P_TraceSight
+// Traces from an eye at (x1, y1, z) to any part of the column
+// at (x2, y2) between bottom and top, ignoring REJECT and the
+// cache. Used to check built REJECT tables against the trace
 //
 
-void P_ScanSights(void) {
+dboolean P_TraceSight(fixed_t x1, fixed_t y1, fixed_t z,
+                      fixed_t x2, fixed_t y2, fixed_t bottom, fixed_t top) {
+    sighttrace_t st;
+
+    st.zstart = z;
+    st.top = top - z;
+    st.bottom = bottom - z;
+    st.trace.x = x1;
+    st.trace.y = y1;
+    st.x2 = x2;
+    st.y2 = y2;
+    st.trace.dx = x2 - x1;
+    st.trace.dy = y2 - y1;
+    st.usevalid = false;
+    st.linevalid = NULL;
+
+    return P_CrossBSPNode(&st, numnodes-1);
+}
+
+//
+// PARALLEL SIGHT SCAN
+// With p_sightthreads above 1, P_ScanSights gathers its checks
+// first, traces them on worker threads and then applies the
+// results in mobj order. Nothing moves while the scan runs and
+// a trace only reads the map, so every result is the same one
+// P_CheckSight would give; demos stay in sync either way.
+//
+// The workers are started the first time they are needed and
+// kept for the rest of the session. Each one sleeps on its own
+// semaphore until it is handed a range of jobs.
+//
+
+#define SIGHTMAXTHREADS     8
+#define SIGHTMINJOBS        32      // per thread, or it isn't worth waking one
+
+enum {
+    SJ_DONE,        // rejected, result already known
+    SJ_HIT,         // answer is in the cache slot
+    SJ_TRACE        // traced by a worker, then stored in the cache slot
+};
+
+typedef struct {
+    mobj_t*         mobj;
+    sighttrace_t    st;
+    sightcache_t*   cache;
+    int             state;
+    dboolean        result;
+} sightjob_t;
+
+typedef struct {
+    int             first;
+    int             count;
+    void*           start;          // posted when there is a range to trace
+    int*            linevalid;      // [numlines] stamps of lines already checked
+    int             linestamp;
+    int             numlinevalid;
+    int             validgen;
+} sightwork_t;
+
+static sightjob_t*  sightjobs = NULL;
+static int          maxsightjobs = 0;
+
+static sightwork_t  sightwork[SIGHTMAXTHREADS];     // [0] is the main thread
+static int          numsightworkers = 1;
+static void*        sightdone = NULL;               // posted by each worker when finished
+
+dboolean    sightcheck = false;
+int         sightcheckcounts[2];    // results checked, mismatches
+
+//
+// P_SightTraceJobs
+//
+
+static void P_SightTraceJobs(sightwork_t* work) {
+    sightjob_t* job;
+    int i;
+
+    for(i = 0; i < work->count; i++) {
+        job = &sightjobs[work->first + i];
+
+        if(job->state == SJ_TRACE) {
+            job->st.linevalid = work->linevalid;
+            job->st.linestamp = ++work->linestamp;
+            job->result = P_CrossBSPNode(&job->st, numnodes-1);
+        }
+    }
+}
+
+//
+// P_SightWorker
+//
+
+static int P_SightWorker(void* data) {
+    sightwork_t* work = (sightwork_t*)data;
+
+    while(1) {
+        I_SemaphoreWait(work->start);
+        P_SightTraceJobs(work);
+        I_SemaphorePost(sightdone);
+    }
+
+    return 0;
+}
+
+//
+// P_StartSightWorkers
+// Returns how many threads, counting the main one,
+// are ready to share a scan
+//
+
+static int P_StartSightWorkers(int numthreads) {
+    if(!sightdone && !(sightdone = I_CreateSemaphore(0))) {
+        return 1;
+    }
+
+    while(numsightworkers < numthreads) {
+        sightwork_t* work = &sightwork[numsightworkers];
+
+        if(!work->start && !(work->start = I_CreateSemaphore(0))) {
+            break;
+        }
+
+        if(!I_CreateThread(P_SightWorker, work)) {
+            break;
+        }
+
+        numsightworkers++;
+    }
+
+    return MIN(numthreads, numsightworkers);
+}
+
+//
+// P_CheckSightJobs
+// With -checksights, traces every result the workers
+// produced again on the main thread and counts mismatches
+//
+
+static void P_CheckSightJobs(int numjobs) {
+    sighttrace_t st;
+    sightjob_t* job;
+    int i;
+
+    for(i = 0; i < numjobs; i++) {
+        job = &sightjobs[i];
+
+        if(job->state == SJ_DONE) {
+            continue;
+        }
+
+        P_SetSightTrace(&st, job->mobj, job->mobj->target);
+        st.usevalid = false;
+
+        sightcheckcounts[0]++;
+
+        if(P_CrossBSPNode(&st, numnodes-1) != job->result) {
+            sightcheckcounts[1]++;
+        }
+    }
+}
+
+//
+// P_ScanSightsParallel
+// Returns false if there is too little to do for
+// minjobs per thread, leaving the scan to the serial loop
+//
+
+static dboolean P_ScanSightsParallel(int numthreads, int minjobs) {
+    sightjob_t*     job;
+    mobj_t*         mobj;
+    dboolean        hit;
+    int             numjobs;
+    int             numtraces;
+    int             traces;
+    int             i;
+    int             j;
+
+    numjobs = 0;
+
+    for(mobj = mobjhead.next; mobj != &mobjhead; mobj = mobj->next) {
+        if(mobj->flags & MF_COUNTKILL && mobj->tics != 1 && mobj->target) {
+            numjobs++;
+        }
+    }
+
+    if(numjobs < minjobs * 2) {
+        return false;
+    }
+
+    numthreads = P_StartSightWorkers(numthreads);
+
+    if(numthreads <= 1) {
+        return false;
+    }
+
+    if(numjobs > maxsightjobs) {
+        maxsightjobs = numjobs;
+        sightjobs = (sightjob_t*)Z_Realloc(sightjobs, sizeof(sightjob_t) * maxsightjobs, PU_STATIC, 0);
+    }
+
+    // query phase: reject and the cache are handled here in
+    // mobj order, exactly as a serial scan would see them
+    numjobs = 0;
+    numtraces = 0;
+
+    for(mobj = mobjhead.next; mobj != &mobjhead; mobj = mobj->next) {
+        if(!(mobj->flags & MF_COUNTKILL) || mobj->tics == 1 || !mobj->target) {
+            continue;
+        }
+
+        job = &sightjobs[numjobs++];
+        job->mobj = mobj;
+        job->result = false;
+
+        if(P_SightRejected(mobj, mobj->target)) {
+            sightcounts[0]++;
+            job->state = SJ_DONE;
+            continue;
+        }
+
+        sightcounts[1]++;
+
+        P_SetSightTrace(&job->st, mobj, mobj->target);
+        job->st.usevalid = false;
+        job->cache = P_LookupSightCache(&job->st, &hit);
+        job->state = hit ? SJ_HIT : SJ_TRACE;
+
+        if(!hit) {
+            numtraces++;
+        }
+    }
+
+    // only traces cost anything; don't wake a worker
+    // for fewer than minjobs of them
+    if(numthreads > numtraces / minjobs) {
+        numthreads = MAX(numtraces / minjobs, 1);
+    }
+
+    // the workers can't allocate, so their line stamps are
+    // set up here, and cleared whenever a new level is loaded
+    for(i = 0; i < numthreads; i++) {
+        sightwork_t* work = &sightwork[i];
+
+        if(work->validgen != sightvalidgen || work->numlinevalid < numlines) {
+            if(work->numlinevalid < numlines) {
+                work->numlinevalid = numlines;
+                work->linevalid = (int*)Z_Realloc(work->linevalid,
+                                                  sizeof(int) * numlines, PU_STATIC, 0);
+            }
+
+            dmemset(work->linevalid, 0, sizeof(int) * work->numlinevalid);
+            work->linestamp = 0;
+            work->validgen = sightvalidgen;
+        }
+    }
+
+    // trace phase; the jobs are split, in order, into ranges
+    // holding the same number of traces for each thread
+    for(i = 0, j = 0, traces = 0; i < numthreads; i++) {
+        int last = (numtraces * (i + 1)) / numthreads;
+
+        sightwork[i].first = j;
+
+        while(j < numjobs && (traces < last || i == numthreads - 1)) {
+            if(sightjobs[j++].state == SJ_TRACE) {
+                traces++;
+            }
+        }
+
+        sightwork[i].count = j - sightwork[i].first;
+    }
+
+    for(i = 1; i < numthreads; i++) {
+        I_SemaphorePost(sightwork[i].start);
+    }
+
+    P_SightTraceJobs(&sightwork[0]);
+
+    for(i = 1; i < numthreads; i++) {
+        I_SemaphoreWait(sightdone);
+    }
+
+    // apply phase, in mobj order. A hit reads its slot only after
+    // every earlier trace has been stored, the same as serially
+    for(i = 0; i < numjobs; i++) {
+        job = &sightjobs[i];
+
+        if(job->state == SJ_TRACE) {
+            job->cache->result = job->result;
+        }
+        else if(job->state == SJ_HIT) {
+            job->result = job->cache->result;
+        }
+
+        if(job->result) {
+            job->mobj->flags |= MF_SEETARGET;
+        }
+    }
+
+    if(sightcheck) {
+        P_CheckSightJobs(numjobs);
+    }
+
+    return true;
+}
+
+//
+// P_ScanSightsThreads
+// The scan itself; the parallel path is only taken with
+// at least minjobs checks for each thread
+//
+
+void P_ScanSightsThreads(int numthreads, int minjobs) {
     mobj_t* mobj;
 
+    for(mobj = mobjhead.next; mobj != &mobjhead; mobj = mobj->next) {
+        if(mobj->flags & MF_COUNTKILL && mobj->tics != 1) {
+            mobj->flags &= ~MF_SEETARGET;
+        }
+    }
+
+    if(numthreads > SIGHTMAXTHREADS) {
+        numthreads = SIGHTMAXTHREADS;
+    }
+
+    if(minjobs < 1) {
+        minjobs = 1;
+    }
+
+    if(numthreads > 1 && P_ScanSightsParallel(numthreads, minjobs)) {
+        return;
+    }
+
     for(mobj = mobjhead.next; mobj != &mobjhead; mobj = mobj->next) {
         // must be killable
         if(!(mobj->flags & MF_COUNTKILL)) {
@@ -375,8 +864,6 @@ void P_ScanSights(void) {
             continue;
         }
 
-        mobj->flags &= ~MF_SEETARGET;
-
         // must have a target
         if(!mobj->target) {
             continue;
@@ -390,3 +877,15 @@ void P_ScanSights(void) {
     }
 }
 
+//
+// P_ScanSights
+// Optimal mobj sight checking that check sights
+// in main tick loop rather from multiple
+// mobj action routines
+//
+
+void P_ScanSights(void) {
+    // -checksights wants every tic it can get through the workers
+    P_ScanSightsThreads((int)p_sightthreads.value, sightcheck ? 1 : SIGHTMINJOBS);
+}
+
@@ -161,6 +161,8 @@ animinfo_t* animinfo;
 //
 
 extern line_t** linespeciallist;
+extern sector_t** scrollsectors;
+extern int numscrollsectors;
 
 //
 // P_InitPicAnims
@@ -314,55 +316,160 @@ sector_t* getNextSector(line_t* line, sector_t* sec) {
 
 
 //
-// P_FindLowestFloorSurrounding()
-// FIND LOWEST FLOOR HEIGHT IN SURROUNDING SECTORS
+// SECTOR NEIGHBORS
 //
-fixed_t    P_FindLowestFloorSurrounding(sector_t* sec) {
-    int            i;
-    line_t*        check;
-    sector_t*      other;
-    fixed_t        floor = sec->floorheight;
+// For every sector, getNextSector() of each of its lines in line
+// order (one entry per line, so duplicates are kept, which
+// P_FindNextHighestFloor's 20 entry limit depends on). Built when
+// the level or a savegame is loaded; P_ModifyLine keeps each line's
+// ML_TWOSIDED, so the lists never change during play.
+//
+// The four plain extrema are cached per sector. A sector's cache
+// is dropped whenever it or a neighbor moves, see
+// P_InvalidateSectorExtrema.
+//
+
+typedef struct {
+    fixed_t     lowestfloor;
+    fixed_t     highestfloor;
+    fixed_t     lowestceiling;
+    fixed_t     highestceiling;
+    dboolean    valid;
+} sectorextrema_t;
 
-    for(i=0 ; i < sec->linecount ; i++) {
-        check = sec->lines[i];
-        other = getNextSector(check,sec);
+static sector_t**       sectorneighbors;
+static int*             sectorneighborfirst;    // numsectors+1 offsets
+static sectorextrema_t* sectorextrema;
 
-        if(!other) {
-            continue;
+//
+// P_InitSectorNeighbors
+//
+
+void P_InitSectorNeighbors(void) {
+    int         i;
+    int         j;
+    int         count;
+    sector_t*   sec;
+    sector_t*   other;
+
+    if(!sectorneighbors) {
+        count = 0;
+        for(i = 0; i < numsectors; i++) {
+            count += sectors[i].linecount;
         }
 
-        if(other->floorheight < floor) {
-            floor = other->floorheight;
+        sectorneighbors = Z_Malloc(sizeof(sector_t*) * (count ? count : 1),
+                                   PU_LEVEL, &sectorneighbors);
+        sectorneighborfirst = Z_Malloc(sizeof(int) * (numsectors + 1),
+                                       PU_LEVEL, &sectorneighborfirst);
+        sectorextrema = Z_Malloc(sizeof(sectorextrema_t) * numsectors,
+                                 PU_LEVEL, &sectorextrema);
+    }
+
+    count = 0;
+    for(i = 0, sec = sectors; i < numsectors; i++, sec++) {
+        sectorneighborfirst[i] = count;
+        sectorextrema[i].valid = false;
+
+        for(j = 0; j < sec->linecount; j++) {
+            other = getNextSector(sec->lines[j], sec);
+
+            if(other) {
+                sectorneighbors[count++] = other;
+            }
         }
     }
-    return floor;
+
+    sectorneighborfirst[numsectors] = count;
 }
 
+//
+// P_InvalidateSectorExtrema
+// Call before (and whenever) sec's floor or ceiling moves
+//
+
+void P_InvalidateSectorExtrema(sector_t* sec) {
+    int i;
+    int n;
+    int end;
+
+    if(!sectorextrema) {
+        return;
+    }
+
+    n = sec - sectors;
+    end = sectorneighborfirst[n + 1];
 
+    sectorextrema[n].valid = false;
+    for(i = sectorneighborfirst[n]; i < end; i++) {
+        sectorextrema[sectorneighbors[i] - sectors].valid = false;
+    }
+}
 
 //
-// P_FindHighestFloorSurrounding()
-// FIND HIGHEST FLOOR HEIGHT IN SURROUNDING SECTORS
+// P_GetSectorExtrema
 //
-fixed_t    P_FindHighestFloorSurrounding(sector_t *sec) {
-    int            i;
-    line_t*        check;
-    sector_t*      other;
-    fixed_t        floor = -500*FRACUNIT;
 
-    for(i=0 ; i < sec->linecount ; i++) {
-        check = sec->lines[i];
-        other = getNextSector(check,sec);
+static sectorextrema_t* P_GetSectorExtrema(sector_t* sec) {
+    sectorextrema_t*    ext;
+    sector_t*           other;
+    int                 i;
+    int                 n;
+    int                 end;
 
-        if(!other) {
-            continue;
+    n = sec - sectors;
+    ext = &sectorextrema[n];
+
+    if(ext->valid) {
+        return ext;
+    }
+
+    ext->lowestfloor = sec->floorheight;
+    ext->highestfloor = -500*FRACUNIT;
+    ext->lowestceiling = D_MAXINT;
+    ext->highestceiling = 0;
+
+    end = sectorneighborfirst[n + 1];
+    for(i = sectorneighborfirst[n]; i < end; i++) {
+        other = sectorneighbors[i];
+
+        if(other->floorheight < ext->lowestfloor) {
+            ext->lowestfloor = other->floorheight;
+        }
+
+        if(other->floorheight > ext->highestfloor) {
+            ext->highestfloor = other->floorheight;
+        }
+
+        if(other->ceilingheight < ext->lowestceiling) {
+            ext->lowestceiling = other->ceilingheight;
         }
 
-        if(other->floorheight > floor) {
-            floor = other->floorheight;
+        if(other->ceilingheight > ext->highestceiling) {
+            ext->highestceiling = other->ceilingheight;
         }
     }
-    return floor;
+
+    ext->valid = true;
+    return ext;
+}
+
+//
+// P_FindLowestFloorSurrounding()
+// FIND LOWEST FLOOR HEIGHT IN SURROUNDING SECTORS
+//
+fixed_t    P_FindLowestFloorSurrounding(sector_t* sec) {
+    return P_GetSectorExtrema(sec)->lowestfloor;
+}
+
+
+
+//
+// P_FindHighestFloorSurrounding()
+// FIND HIGHEST FLOOR HEIGHT IN SURROUNDING SECTORS
+//
+fixed_t    P_FindHighestFloorSurrounding(sector_t *sec) {
+    return P_GetSectorExtrema(sec)->highestfloor;
 }
 
 
@@ -379,18 +486,14 @@ fixed_t P_FindNextHighestFloor(sector_t* sec, int currentheight) {
     int         i;
     int         h;
     int         min;
-    line_t*     check;
+    int         end;
     sector_t*   other;
     fixed_t     height = currentheight;
     fixed_t     heightlist[MAX_ADJOINING_SECTORS];
 
-    for(i = 0, h = 0; i < sec->linecount; i++) {
-        check = sec->lines[i];
-        other = getNextSector(check,sec);
-
-        if(!other) {
-            continue;
-        }
+    end = sectorneighborfirst[(sec - sectors) + 1];
+    for(i = sectorneighborfirst[sec - sectors], h = 0; i < end; i++) {
+        other = sectorneighbors[i];
 
         if(other->floorheight > height) {
             heightlist[h++] = other->floorheight;
@@ -424,24 +527,7 @@ fixed_t P_FindNextHighestFloor(sector_t* sec, int currentheight) {
 // FIND LOWEST CEILING IN THE SURROUNDING SECTORS
 //
 fixed_t P_FindLowestCeilingSurrounding(sector_t* sec) {
-    int         i;
-    line_t*     check;
-    sector_t*   other;
-    fixed_t     height = D_MAXINT;
-
-    for(i = 0; i < sec->linecount; i++) {
-        check = sec->lines[i];
-        other = getNextSector(check,sec);
-
-        if(!other) {
-            continue;
-        }
-
-        if(other->ceilingheight < height) {
-            height = other->ceilingheight;
-        }
-    }
-    return height;
+    return P_GetSectorExtrema(sec)->lowestceiling;
 }
 
 
@@ -449,27 +535,76 @@ fixed_t P_FindLowestCeilingSurrounding(sector_t* sec) {
 // FIND HIGHEST CEILING IN THE SURROUNDING SECTORS
 //
 fixed_t    P_FindHighestCeilingSurrounding(sector_t* sec) {
-    int         i;
-    line_t*     check;
-    sector_t*   other;
-    fixed_t     height = 0;
+    return P_GetSectorExtrema(sec)->highestceiling;
+}
 
-    for(i = 0; i < sec->linecount; i++) {
-        check = sec->lines[i];
-        other = getNextSector(check,sec);
 
-        if(!other) {
-            continue;
-        }
 
-        if(other->ceilingheight > height) {
-            height = other->ceilingheight;
-        }
+//
+// P_InitTagLists
+// Chains sectors and lines into hash buckets keyed by tag.
+// Each chain is in ascending index order, so walking it gives
+// the same order as scanning the whole array. Must be redone
+// whenever tags are rewritten (map load, savegame load)
+//
+
+void P_InitTagLists(void) {
+    int i;
+    int j;
+
+    for(i = 0; i < numsectors; i++) {
+        sectors[i].firsttag = -1;
+    }
+
+    for(i = numsectors - 1; i >= 0; i--) {
+        j = (unsigned int)sectors[i].tag % (unsigned int)numsectors;
+        sectors[i].nexttag = sectors[j].firsttag;
+        sectors[j].firsttag = i;
+    }
+
+    for(i = 0; i < numlines; i++) {
+        lines[i].firsttag = -1;
+    }
+
+    for(i = numlines - 1; i >= 0; i--) {
+        j = (unsigned int)lines[i].tag % (unsigned int)numlines;
+        lines[i].nexttag = lines[j].firsttag;
+        lines[j].firsttag = i;
+    }
+}
+
+//
+// P_NextSectorTag
+// Returns the next sector after start with the given tag,
+// start being -1 or the result of a previous call
+//
+
+int P_NextSectorTag(int tag, int start) {
+    start = start >= 0 ? sectors[start].nexttag :
+            sectors[(unsigned int)tag % (unsigned int)numsectors].firsttag;
+
+    while(start >= 0 && sectors[start].tag != tag) {
+        start = sectors[start].nexttag;
     }
-    return height;
+
+    return start;
 }
 
+//
+// P_NextLineTag
+// Same as P_NextSectorTag for linedefs
+//
+
+int P_NextLineTag(int tag, int start) {
+    start = start >= 0 ? lines[start].nexttag :
+            lines[(unsigned int)tag % (unsigned int)numlines].firsttag;
+
+    while(start >= 0 && lines[start].tag != tag) {
+        start = lines[start].nexttag;
+    }
 
+    return start;
+}
 
 //
 // P_FindSectorFromLineTag
@@ -477,14 +612,7 @@ fixed_t    P_FindHighestCeilingSurrounding(sector_t* sec) {
 //
 
 int P_FindSectorFromLineTag(line_t* line, int start) {
-    int    i;
-
-    for(i = start + 1; i < numsectors; i++) {
-        if(sectors[i].tag == line->tag) {
-            return i;
-        }
-    }
-    return -1;
+    return P_NextSectorTag(line->tag, start);
 }
 
 
@@ -493,15 +621,7 @@ int P_FindSectorFromLineTag(line_t* line, int start) {
 //
 
 int P_FindLinedefFromTag(int tag) {
-    int i = 0;
-
-    for(i = 0; i < numlines; i++) {
-        if(lines[i].tag == tag) {
-            return i;
-        }
-    }
-
-    return -1;
+    return P_NextLineTag(tag, -1);
 }
 
 //
@@ -510,15 +630,7 @@ int P_FindLinedefFromTag(int tag) {
 //
 
 int P_FindSectorFromTag(int tag) {
-    int i = 0;
-
-    for(i = 0; i < numsectors; i++) {
-        if(sectors[i].tag == tag) {
-            return i;
-        }
-    }
-
-    return -1;
+    return P_NextSectorTag(tag, -1);
 }
 
 //
@@ -528,10 +640,9 @@ int P_FindSectorFromTag(int tag) {
 dboolean P_ActivateLineByTag(int tag, mobj_t* activator) {
     int i;
 
-    for(i = 0; i < numlines; i++) {
-        if(lines[i].tag == tag) {
-            return P_UseSpecialLine(activator, &lines[i], 0);
-        }
+    i = P_NextLineTag(tag, -1);
+    if(i >= 0) {
+        return P_UseSpecialLine(activator, &lines[i], 0);
     }
 
     return 1;
@@ -560,57 +671,55 @@ static int P_ModifyLine(int tag1, int tag2, int type) {
     
     line2 = &lines[linenum];
 
-    for(i = 0; i < numlines; i++) {
+    for(i = P_NextLineTag(tag1, -1); i >= 0; i = P_NextLineTag(tag1, i)) {
         line1 = &lines[i];
-        if(line1->tag == tag1) {
-            switch(type) {
-            case modl_flags:
-                if(line1->flags & ML_TWOSIDED) {
-                    line1->flags = (line2->flags | ML_TWOSIDED);
-                }
-                else {
-                    line1->flags = line2->flags;
-                    line1->flags &= ~ML_TWOSIDED;
-                }
-                break;
-            case modl_texture:
-                sides[line1->sidenum[0]].bottomtexture = sides[line2->sidenum[0]].bottomtexture;
-                sides[line1->sidenum[0]].midtexture = sides[line2->sidenum[0]].midtexture;
-                sides[line1->sidenum[0]].toptexture = sides[line2->sidenum[0]].toptexture;
-
-                if(line1->flags & ML_TWOSIDED || line1->sidenum[1] != NO_SIDE_INDEX) {
-                    sides[line1->sidenum[1]].bottomtexture = sides[line2->sidenum[1]].bottomtexture;
-                    sides[line1->sidenum[1]].midtexture = sides[line2->sidenum[1]].midtexture;
-                    sides[line1->sidenum[1]].toptexture = sides[line2->sidenum[1]].toptexture;
-                }
-
-                if(line1->flags & ML_SWITCHX02 &&
-                        !sides[line1->sidenum[0]].toptexture) {
-                    line1->flags &= ~ML_SWITCHX02;
-                }
+        switch(type) {
+        case modl_flags:
+            if(line1->flags & ML_TWOSIDED) {
+                line1->flags = (line2->flags | ML_TWOSIDED);
+            }
+            else {
+                line1->flags = line2->flags;
+                line1->flags &= ~ML_TWOSIDED;
+            }
+            break;
+        case modl_texture:
+            sides[line1->sidenum[0]].bottomtexture = sides[line2->sidenum[0]].bottomtexture;
+            sides[line1->sidenum[0]].midtexture = sides[line2->sidenum[0]].midtexture;
+            sides[line1->sidenum[0]].toptexture = sides[line2->sidenum[0]].toptexture;
+
+            if(line1->flags & ML_TWOSIDED || line1->sidenum[1] != NO_SIDE_INDEX) {
+                sides[line1->sidenum[1]].bottomtexture = sides[line2->sidenum[1]].bottomtexture;
+                sides[line1->sidenum[1]].midtexture = sides[line2->sidenum[1]].midtexture;
+                sides[line1->sidenum[1]].toptexture = sides[line2->sidenum[1]].toptexture;
+            }
 
-                if(line1->flags & (ML_SWITCHX04 | ML_SWITCHX08) &&
-                        !sides[line1->sidenum[0]].bottomtexture) {
-                    line1->flags &= ~(ML_SWITCHX04 | ML_SWITCHX08);
-                }
+            if(line1->flags & ML_SWITCHX02 &&
+                    !sides[line1->sidenum[0]].toptexture) {
+                line1->flags &= ~ML_SWITCHX02;
+            }
 
-                if(line1->flags & (ML_SWITCHX02 | ML_SWITCHX04) &&
-                        !sides[line1->sidenum[0]].midtexture) {
-                    line1->flags &= ~(ML_SWITCHX02 | ML_SWITCHX04);
-                }
+            if(line1->flags & (ML_SWITCHX04 | ML_SWITCHX08) &&
+                    !sides[line1->sidenum[0]].bottomtexture) {
+                line1->flags &= ~(ML_SWITCHX04 | ML_SWITCHX08);
+            }
 
-                if(line1->flags & (ML_SWITCHX02 | ML_SWITCHX08) &&
-                        !sides[line1->sidenum[0]].toptexture) {
-                    line1->flags &= ~(ML_SWITCHX02 | ML_SWITCHX08);
-                }
+            if(line1->flags & (ML_SWITCHX02 | ML_SWITCHX04) &&
+                    !sides[line1->sidenum[0]].midtexture) {
+                line1->flags &= ~(ML_SWITCHX02 | ML_SWITCHX04);
+            }
 
-                break;
-            case modl_data:
-                line1->special = line2->special;
-                break;
-            default:
-                break;
+            if(line1->flags & (ML_SWITCHX02 | ML_SWITCHX08) &&
+                    !sides[line1->sidenum[0]].toptexture) {
+                line1->flags &= ~(ML_SWITCHX02 | ML_SWITCHX08);
             }
+
+            break;
+        case modl_data:
+            line1->special = line2->special;
+            break;
+        default:
+            break;
         }
     }
 
@@ -672,6 +781,10 @@ static int P_ModifySector(line_t *line, int tag, int type) {
         }
     }
 
+    if(type == mods_flags) {
+        P_InitScrollSectors();
+    }
+
     return rtn;
 }
 
@@ -726,9 +839,8 @@ int P_RandomLineTrigger(line_t* line, mobj_t* thing, int side) {
     int i = 0;
     int count = 0;
 
-    for(i = 0; i < numlines; i++) {
-        if(lines[i].tag == line->tag &&
-                SPECIALMASK(lines[i].special) != SPECIALMASK(line->special)) {
+    for(i = P_NextLineTag(line->tag, -1); i >= 0; i = P_NextLineTag(line->tag, i)) {
+        if(SPECIALMASK(lines[i].special) != SPECIALMASK(line->special)) {
             count++;
         }
     }
@@ -739,9 +851,8 @@ int P_RandomLineTrigger(line_t* line, mobj_t* thing, int side) {
     linelist = (line_t **)Z_Malloc(count*sizeof(line_t *), PU_LEVEL, NULL);
     randLine = linelist;
 
-    for(i = 0; i < numlines; i++) {
-        if(lines[i].tag == line->tag &&
-                SPECIALMASK(lines[i].special) != SPECIALMASK(line->special)) {
+    for(i = P_NextLineTag(line->tag, -1); i >= 0; i = P_NextLineTag(line->tag, i)) {
+        if(SPECIALMASK(lines[i].special) != SPECIALMASK(line->special)) {
             *randLine++ = &lines[i];
         }
     }
@@ -1886,33 +1997,30 @@ void P_UpdateSpecials(void) {
     }
 
     // UPDATE SCROLLING FLATS
-    for(i = 0; i < numsectors; i++) {
-        sector = &sectors[i];
-
-        if(sector->flags & (MS_SCROLLFLOOR|MS_SCROLLCEILING)) {
-            fixed_t speed;
+    for(i = 0; i < numscrollsectors; i++) {
+        fixed_t speed;
 
-            if(sector->flags & MS_SCROLLFAST) {
-                speed = 3*FRACUNIT;
-            }
-            else {
-                speed = FRACUNIT;
-            }
+        sector = scrollsectors[i];
 
-            if(sector->flags & MS_SCROLLLEFT) {
-                sector->xoffset += speed;
-            }
-            if(sector->flags & MS_SCROLLRIGHT) {
-                sector->xoffset -= speed;
-            }
-            if(sector->flags & MS_SCROLLUP) {
-                sector->yoffset += speed;
-            }
-            if(sector->flags & MS_SCROLLDOWN) {
-                sector->yoffset -= speed;
-            }
+        if(sector->flags & MS_SCROLLFAST) {
+            speed = 3*FRACUNIT;
+        }
+        else {
+            speed = FRACUNIT;
         }
 
+        if(sector->flags & MS_SCROLLLEFT) {
+            sector->xoffset += speed;
+        }
+        if(sector->flags & MS_SCROLLRIGHT) {
+            sector->xoffset -= speed;
+        }
+        if(sector->flags & MS_SCROLLUP) {
+            sector->yoffset += speed;
+        }
+        if(sector->flags & MS_SCROLLDOWN) {
+            sector->yoffset -= speed;
+        }
     }
 
     // SKY TICKER
@@ -1921,7 +2029,7 @@ void P_UpdateSpecials(void) {
     }
 
     // DO BUTTONS
-    for(i = 0; i < MAXBUTTONS; i++) {
+    for(i = 0; i < MAXBUTTONS && numactivebuttons; i++) {
         if(buttonlist[i].btimer) {
             buttonlist[i].btimer--;
             if(!buttonlist[i].btimer) {
@@ -1944,6 +2052,7 @@ void P_UpdateSpecials(void) {
 
                 S_StartSound((mobj_t *)&buttonlist[i].line->frontsector->soundorg, sfx_switch1);
                 dmemset(&buttonlist[i],0,sizeof(button_t));
+                numactivebuttons--;
             }
         }
     }
@@ -1966,6 +2075,31 @@ void P_UpdateSpecials(void) {
 line_t**    linespeciallist;
 short       numlinespecials;
 
+sector_t**  scrollsectors;
+int         numscrollsectors;
+
+//
+// P_InitScrollSectors
+// Collects the sectors with scrolling flats, so P_UpdateSpecials
+// doesn't have to test every sector each tic. Must be called
+// again whenever sector flags are rewritten
+//
+
+void P_InitScrollSectors(void) {
+    int i;
+
+    if(!scrollsectors) {
+        scrollsectors = Z_Malloc(sizeof(sector_t*) * numsectors, PU_LEVEL, &scrollsectors);
+    }
+
+    numscrollsectors = 0;
+    for(i = 0; i < numsectors; i++) {
+        if(sectors[i].flags & (MS_SCROLLFLOOR|MS_SCROLLCEILING)) {
+            scrollsectors[numscrollsectors++] = &sectors[i];
+        }
+    }
+}
+
 void P_AddSectorSpecial(sector_t* sector) {
     if(!sector->special) {
         return;
@@ -2154,5 +2288,10 @@ void P_SpawnSpecials(void) {
     for(i = 0; i < MAXBUTTONS; i++) {
         dmemset(&buttonlist[i],0,sizeof(button_t));
     }
+
+    numactivebuttons = 0;
+
+    //    Init scrolling flats
+    P_InitScrollSectors();
 }
 
@@ -70,6 +70,12 @@ fixed_t     P_FindLowestCeilingSurrounding(sector_t* sec);
 fixed_t     P_FindHighestCeilingSurrounding(sector_t* sec);
 int         P_FindSectorFromLineTag(line_t* line, int start);
 dboolean    P_ActivateLineByTag(int tag, mobj_t* activator);
+void        P_InitTagLists(void);
+void        P_InitScrollSectors(void);
+void        P_InitSectorNeighbors(void);
+void        P_InvalidateSectorExtrema(sector_t* sec);
+int         P_NextSectorTag(int tag, int start);
+int         P_NextLineTag(int tag, int start);
 
 
 //
@@ -203,6 +209,7 @@ typedef struct {
 #define BUTTONTIME      15
 
 extern button_t    buttonlist[MAXBUTTONS];
+extern int         numactivebuttons;
 
 void P_ChangeSwitchTexture(line_t* line, int useAgain);
 
@@ -40,6 +40,7 @@
 
 
 button_t buttonlist[MAXBUTTONS];
+int      numactivebuttons;
 
 
 //
@@ -64,6 +65,10 @@ void P_StartButton(line_t* line, bwhere_e w, int texture, int time) {
             buttonlist[i].btexture = texture;
             buttonlist[i].btimer = time;
 
+            if(time) {
+                numactivebuttons++;
+            }
+
             if(SWITCHMASK(line->flags)) {
                 buttonlist[i].soundorg = (mobj_t *)&line->frontsector->soundorg;
             }
@@ -30,6 +30,8 @@
 #include "doomstat.h"
 #include "z_zone.h"
 #include "p_local.h"
+#include "p_tick.h"
+#include "p_saveg.h"
 #include "p_macros.h"
 #include "st_stuff.h"
 #include "am_map.h"
@@ -40,10 +42,12 @@
 #include "r_wipe.h"
 #include "p_setup.h"
 #include "g_demo.h"
+#include "d_trace.h"
 
 CVAR_EXTERNAL(i_interpolateframes);
 CVAR_EXTERNAL(p_damageindicator);
 CVAR_EXTERNAL(r_wipe);
+CVAR_EXTERNAL(p_groupthinkers);
 
 int     leveltime;
 
@@ -67,6 +71,196 @@ mobj_t      mobjhead;        // Both the head and tail of the mobj list.
 mobj_t      *currentmobj;
 thinker_t   *currentthinker;
 
+//
+// THINKER CLASSES
+//
+// With p_groupthinkers set, thinkers are also kept in packed
+// arrays, one per think function, and each array is run in one
+// go through a single hoisted call target instead of walking the
+// mixed list. Thinkers still run in creation order within their
+// class, but classes run one after another and thinkers spawned
+// during a tic wait for the next one. That is not the order the
+// game was recorded with, so grouping is never used for demos
+// or netgames.
+//
+
+#define MAXTHINKERCLASSES   64
+
+typedef struct {
+    actionf_p1  func;
+    thinker_t** list;
+    int         count;
+    int         max;
+} thinkerclass_t;
+
+static thinkerclass_t   thinkerclasses[MAXTHINKERCLASSES];
+static int              numthinkerclasses = 0;
+static thinker_t**      pendingthinkers = NULL;
+static int              numpendingthinkers = 0;
+static int              maxpendingthinkers = 0;
+static dboolean         thinkerclassesvalid = false;
+
+static void P_UnlinkThinker(thinker_t* thinker);
+
+//
+// P_ResetThinkerClasses
+// Must be called whenever thinkers are freed behind
+// the back of P_RemoveThinker
+//
+
+void P_ResetThinkerClasses(void) {
+    int i;
+
+    for(i = 0; i < numthinkerclasses; i++) {
+        thinkerclasses[i].count = 0;
+    }
+
+    numthinkerclasses = 0;
+    numpendingthinkers = 0;
+    thinkerclassesvalid = false;
+}
+
+//
+// P_AddPendingThinker
+//
+
+static void P_AddPendingThinker(thinker_t* thinker) {
+    if(numpendingthinkers >= maxpendingthinkers) {
+        maxpendingthinkers = maxpendingthinkers ? maxpendingthinkers * 2 : 256;
+        pendingthinkers = Z_Realloc(pendingthinkers,
+                                    sizeof(thinker_t*) * maxpendingthinkers, PU_STATIC, 0);
+    }
+
+    pendingthinkers[numpendingthinkers++] = thinker;
+}
+
+//
+// P_ClassifyThinker
+// Returns false if there are more think functions than classes
+//
+
+static dboolean P_ClassifyThinker(thinker_t* thinker) {
+    thinkerclass_t* tc;
+    int i;
+
+    // removed before it ever ran
+    if(thinker->function.acp1 == (actionf_p1)P_UnlinkThinker) {
+        currentthinker = thinker;
+        P_UnlinkThinker(thinker);
+        return true;
+    }
+
+    for(i = 0; i < numthinkerclasses; i++) {
+        if(thinkerclasses[i].func == thinker->function.acp1) {
+            break;
+        }
+    }
+
+    if(i == numthinkerclasses) {
+        if(numthinkerclasses == MAXTHINKERCLASSES) {
+            return false;
+        }
+
+        thinkerclasses[numthinkerclasses++].func = thinker->function.acp1;
+    }
+
+    tc = &thinkerclasses[i];
+
+    if(tc->count >= tc->max) {
+        tc->max = tc->max ? tc->max * 2 : 64;
+        tc->list = Z_Realloc(tc->list, sizeof(thinker_t*) * tc->max, PU_STATIC, 0);
+    }
+
+    tc->list[tc->count++] = thinker;
+    return true;
+}
+
+//
+// P_BuildThinkerClasses
+//
+
+static dboolean P_BuildThinkerClasses(void) {
+    thinker_t* thinker;
+    thinker_t* next;
+    int i;
+
+    if(!thinkerclassesvalid) {
+        P_ResetThinkerClasses();
+
+        for(thinker = thinkercap.next; thinker != &thinkercap; thinker = next) {
+            next = thinker->next;
+            P_AddPendingThinker(thinker);
+        }
+
+        thinkerclassesvalid = true;
+    }
+
+    for(i = 0; i < numpendingthinkers; i++) {
+        if(!P_ClassifyThinker(pendingthinkers[i])) {
+            P_ResetThinkerClasses();
+            return false;
+        }
+    }
+
+    numpendingthinkers = 0;
+    return true;
+}
+
+//
+// P_RunThinkerClasses
+//
+
+static void P_RunThinkerClasses(void) {
+    thinkerclass_t* tc;
+    actionf_p1 func;
+    int i;
+    int j;
+    int k;
+
+    for(i = 0; i < numthinkerclasses; i++) {
+        tc = &thinkerclasses[i];
+        func = tc->func;
+
+        if(!func) {
+            continue;
+        }
+
+        for(j = 0; j < tc->count; j++) {
+            currentthinker = tc->list[j];
+
+            if(currentthinker->function.acp1 == func) {
+                func(currentthinker);
+            }
+            else if(currentthinker->function.acp1 &&
+                    currentthinker->function.acp1 != (actionf_p1)P_UnlinkThinker) {
+                currentthinker->function.acp1(currentthinker);
+            }
+        }
+    }
+
+    // free removed thinkers and move any that
+    // changed their think function to the right class
+    for(i = 0; i < numthinkerclasses; i++) {
+        tc = &thinkerclasses[i];
+
+        for(j = 0, k = 0; j < tc->count; j++) {
+            thinker_t* thinker = tc->list[j];
+
+            if(thinker->function.acp1 == (actionf_p1)P_UnlinkThinker) {
+                currentthinker = thinker;
+                P_UnlinkThinker(thinker);
+            }
+            else if(thinker->function.acp1 != tc->func) {
+                P_AddPendingThinker(thinker);
+            }
+            else {
+                tc->list[k++] = thinker;
+            }
+        }
+
+        tc->count = k;
+    }
+}
 
 //
 // P_InitThinkers
@@ -75,6 +269,9 @@ thinker_t   *currentthinker;
 void P_InitThinkers(void) {
     thinkercap.prev = thinkercap.next  = &thinkercap;
     mobjhead.next = mobjhead.prev = &mobjhead;
+
+    P_ResetThinkerClasses();
+    P_ClearMobjSlots();
 }
 
 //
@@ -87,6 +284,10 @@ void P_AddThinker(thinker_t* thinker) {
     thinker->next = &thinkercap;
     thinker->prev = thinkercap.prev;
     thinkercap.prev = thinker;
+
+    if(thinkerclassesvalid) {
+        P_AddPendingThinker(thinker);
+    }
 }
 
 //
@@ -111,6 +312,185 @@ void P_RemoveThinker(thinker_t* thinker) {
     P_MacroDetachThinker(thinker);
 }
 
+//
+// MOBJ SLOTS
+//
+// Every mobj on the mobj list owns a slot (mobj->slot, 1-based so a
+// zeroed mobj is unslotted) into a set of packed arrays that mirror
+// its position and the subsector whose sector list it is linked in.
+// The mirrors are written through from P_SetThingPosition and
+// P_UnsetThingPosition, so they follow every move that relinks the
+// thing. Fields that are written all over the game code (z, flags,
+// target) stay on the mobj only; the playsim loops need their live
+// values anyway.
+//
+// Scans that only need to cull by position or find the things of
+// one subsector (sprites, automap) walk these arrays instead of
+// chasing mobj pointers through every sector's thinglist.
+//
+
+int             nummobjslots = 0;       // high water mark
+mobj_t**        mobjslotmobj = NULL;
+fixed_t*        mobjslotx = NULL;
+fixed_t*        mobjsloty = NULL;
+int*            mobjslotsub = NULL;     // -1 if not in a sector list
+int*            subsectormobjs = NULL;  // slots grouped by subsector
+int*            subsectormobjfirst = NULL;
+
+static int      maxmobjslots = 0;
+static int*     mobjslotfree = NULL;
+static int      nummobjslotfree = 0;
+static int      maxsubsectormobjs = 0;
+static int      maxsubsectormobjfirst = 0;
+static dboolean mobjslotsdirty = true;
+
+//
+// P_ClearMobjSlots
+// Must be called whenever mobjs are dropped behind
+// the back of P_UnlinkMobj
+//
+
+void P_ClearMobjSlots(void) {
+    nummobjslots = 0;
+    nummobjslotfree = 0;
+    mobjslotsdirty = true;
+}
+
+//
+// P_AllocMobjSlot
+//
+
+static void P_AllocMobjSlot(mobj_t* mobj) {
+    int slot;
+
+    if(nummobjslotfree) {
+        slot = mobjslotfree[--nummobjslotfree];
+    }
+    else {
+        if(nummobjslots >= maxmobjslots) {
+            maxmobjslots = maxmobjslots ? maxmobjslots * 2 : 1024;
+            mobjslotmobj = Z_Realloc(mobjslotmobj, sizeof(mobj_t*) * maxmobjslots, PU_STATIC, 0);
+            mobjslotx = Z_Realloc(mobjslotx, sizeof(fixed_t) * maxmobjslots, PU_STATIC, 0);
+            mobjsloty = Z_Realloc(mobjsloty, sizeof(fixed_t) * maxmobjslots, PU_STATIC, 0);
+            mobjslotsub = Z_Realloc(mobjslotsub, sizeof(int) * maxmobjslots, PU_STATIC, 0);
+            mobjslotfree = Z_Realloc(mobjslotfree, sizeof(int) * maxmobjslots, PU_STATIC, 0);
+        }
+
+        slot = nummobjslots++;
+    }
+
+    mobj->slot = slot + 1;
+    mobjslotmobj[slot] = mobj;
+    mobjslotx[slot] = mobj->x;
+    mobjsloty[slot] = mobj->y;
+
+    // P_SetThingPosition has already linked it, before it had a slot
+    if(!(mobj->flags & MF_NOSECTOR) && mobj->subsector) {
+        mobjslotsub[slot] = mobj->subsector - subsectors;
+    }
+    else {
+        mobjslotsub[slot] = -1;
+    }
+
+    mobjslotsdirty = true;
+}
+
+//
+// P_FreeMobjSlot
+//
+
+static void P_FreeMobjSlot(mobj_t* mobj) {
+    int slot = mobj->slot - 1;
+
+    if(slot < 0) {
+        return;
+    }
+
+    mobjslotmobj[slot] = NULL;
+    mobjslotsub[slot] = -1;
+    mobjslotfree[nummobjslotfree++] = slot;
+    mobj->slot = 0;
+
+    mobjslotsdirty = true;
+}
+
+//
+// P_SetMobjSlotPosition
+// Called by P_SetThingPosition/P_UnsetThingPosition.
+// Pass NULL for ss when the thing leaves its sector list
+//
+
+void P_SetMobjSlotPosition(mobj_t* mobj, subsector_t* ss) {
+    int slot = mobj->slot - 1;
+
+    if(slot < 0) {
+        return;
+    }
+
+    mobjslotx[slot] = mobj->x;
+    mobjsloty[slot] = mobj->y;
+    mobjslotsub[slot] = ss ? ss - subsectors : -1;
+
+    mobjslotsdirty = true;
+}
+
+//
+// P_GroupMobjSlots
+// Counting sort of the slots by subsector, into
+// subsectormobjs[subsectormobjfirst[i] .. subsectormobjfirst[i+1]].
+// Only redone when something moved since the last call
+//
+
+void P_GroupMobjSlots(void) {
+    int i;
+    int count;
+
+    if(!mobjslotsdirty) {
+        return;
+    }
+
+    if(maxsubsectormobjfirst < numsubsectors + 1) {
+        maxsubsectormobjfirst = numsubsectors + 1;
+        subsectormobjfirst = Z_Realloc(subsectormobjfirst,
+                                       sizeof(int) * maxsubsectormobjfirst, PU_STATIC, 0);
+    }
+
+    if(maxsubsectormobjs < nummobjslots) {
+        maxsubsectormobjs = maxmobjslots;
+        subsectormobjs = Z_Realloc(subsectormobjs,
+                                   sizeof(int) * maxsubsectormobjs, PU_STATIC, 0);
+    }
+
+    dmemset(subsectormobjfirst, 0, sizeof(int) * (numsubsectors + 1));
+
+    for(i = 0; i < nummobjslots; i++) {
+        if(mobjslotsub[i] >= 0) {
+            subsectormobjfirst[mobjslotsub[i] + 1]++;
+        }
+    }
+
+    for(i = 0, count = 0; i <= numsubsectors; i++) {
+        count += subsectormobjfirst[i];
+        subsectormobjfirst[i] = count;
+    }
+
+    // subsectormobjfirst[s] is now the start of subsector s; it is
+    // used as the fill cursor, which leaves it at the start of s+1,
+    // so shift everything back up by one afterwards
+    for(i = 0; i < nummobjslots; i++) {
+        if(mobjslotsub[i] >= 0) {
+            subsectormobjs[subsectormobjfirst[mobjslotsub[i]]++] = i;
+        }
+    }
+
+    for(i = numsubsectors; i > 0; i--) {
+        subsectormobjfirst[i] = subsectormobjfirst[i - 1];
+    }
+
+    subsectormobjfirst[0] = 0;
+    mobjslotsdirty = false;
+}
+
 //
 // P_LinkMobj
 //
@@ -120,6 +500,8 @@ void P_LinkMobj(mobj_t* mobj) {
     mobj->next = &mobjhead;
     mobj->prev = mobjhead.prev;
     mobjhead.prev = mobj;
+
+    P_AllocMobjSlot(mobj);
 }
 
 //
@@ -127,6 +509,8 @@ void P_LinkMobj(mobj_t* mobj) {
 //
 
 void P_UnlinkMobj(mobj_t* mobj) {
+    P_FreeMobjSlot(mobj);
+
     /* Remove from main mobj list */
     mobj_t* next = currentmobj->next;
 
@@ -137,11 +521,98 @@ void P_UnlinkMobj(mobj_t* mobj) {
     (next->prev = currentmobj = mobj->prev)->next = next;
 }
 
+//
+// P_MobjDormant
+//
+// With GF_DORMANTMONSTERS, a monster idling in its spawn states is
+// not thought at all while it can't see the player A_Look gave it
+// and every other player is rejected from its sector. P_ScanSights
+// still sets MF_SEETARGET for skipped monsters, so that flag is the
+// sight wake. Noise (the sector soundtarget), damage (a target that
+// isn't a player) or the player coming into view make it fail the
+// test again on the next tic, so nothing has to be stored to wake
+// it up. Skipped monsters do not call P_Random, which is why demos
+// always think everything.
+//
+
+int numdormantmobjs = 0;
+
+static dboolean P_MobjDormant(mobj_t* mo) {
+    state_t*    spawn;
+    mobj_t*     pmo;
+    int         s1;
+    int         pnum;
+    int         i;
+
+    if(mo->player || !(mo->flags & MF_COUNTKILL) || mo->health <= 0) {
+        return false;
+    }
+
+    if(mo->mobjfunc) {
+        return false;
+    }
+
+    // P_LookForPlayers picks a player before checking sight, so a
+    // player target alone doesn't mean the monster is awake. With no
+    // target yet there is no sight result, so let A_Look pick one
+    if(!mo->target || !mo->target->player || (mo->flags & MF_SEETARGET)) {
+        return false;
+    }
+
+    // P_ScanSights skips monsters about to change state
+    if(mo->tics == 1) {
+        return false;
+    }
+
+    if(mo->momx || mo->momy || mo->momz || mo->z != mo->floorz) {
+        return false;
+    }
+
+    if(mo->subsector->sector->soundtarget) {
+        return false;
+    }
+
+    // S_*_STND loops are one or two states long
+    spawn = &states[mo->info->spawnstate];
+
+    if(mo->state != spawn && &states[mo->state->nextstate] != spawn) {
+        return false;
+    }
+
+    s1 = mo->subsector->sector - sectors;
+
+    for(i = 0; i < MAXPLAYERS; i++) {
+        if(!playeringame[i] || !(pmo = players[i].mo)) {
+            continue;
+        }
+
+        // same lookup as P_CheckSight
+        pnum = s1 * numsectors + (pmo->subsector->sector - sectors);
+
+        if(rejectmatrix[pnum >> 3] & (1 << (pnum & 7))) {
+            continue;
+        }
+
+        // already traced by P_ScanSights this tic
+        if(pmo == mo->target) {
+            continue;
+        }
+
+        return false;
+    }
+
+    return true;
+}
+
 //
 // P_RunMobjs
 //
 
 void P_RunMobjs(void) {
+    dboolean dormant = (gameflags & GF_DORMANTMONSTERS) && !demoplayback && !demorecording;
+
+    numdormantmobjs = 0;
+
     for(currentmobj = mobjhead.next; currentmobj != &mobjhead; currentmobj = currentmobj->next) {
         if(!currentmobj) {
             CON_Warnf("P_RunMobjs: Null mobj in linked list!\n");
@@ -157,6 +628,11 @@ void P_RunMobjs(void) {
             continue;
         }
 
+        if(dormant && P_MobjDormant(currentmobj)) {
+            numdormantmobjs++;
+            continue;
+        }
+
         if(!currentmobj->player) {
             // [kex] don't bother if about to be removed
             if(currentmobj->mobjfunc != P_SafeRemoveMobj) {
@@ -180,6 +656,18 @@ void P_RunMobjs(void) {
 //
 
 void P_RunThinkers(void) {
+    if(p_groupthinkers.value && !demoplayback && !demorecording && !netgame) {
+        if(P_BuildThinkerClasses()) {
+            P_RunThinkerClasses();
+            return;
+        }
+    }
+
+    // classes go stale while the plain list is in use
+    if(thinkerclassesvalid) {
+        P_ResetThinkerClasses();
+    }
+
     for(currentthinker = thinkercap.next;
             currentthinker != &thinkercap;
             currentthinker = currentthinker->next) {
@@ -265,6 +753,114 @@ static void P_UpdateFrameStates(void) {
     }
 }
 
+//
+// P_HashValue
+// FNV-1a over the four bytes of a value, low byte first,
+// so the result doesn't depend on host byte order
+//
+
+static unsigned int P_HashValue(unsigned int hash, unsigned int value) {
+    int i;
+
+    for(i = 0; i < 4; i++) {
+        hash ^= (value & 0xff);
+        hash *= 16777619u;
+        value >>= 8;
+    }
+
+    return hash;
+}
+
+//
+// P_WorldHashes
+// Hashes the deterministic playsim state, one value each for
+// the rng, sectors, players and every mobj. Two runs of the
+// same demo or session must produce the same values on every
+// platform
+//
+
+void P_WorldHashes(unsigned int* hashes) {
+    unsigned int hash;
+    mobj_t* mo;
+    int i;
+    int j;
+
+    hash = P_HashValue(2166136261u, leveltime);
+
+    for(i = 0; i < NUMPRCLASS; i++) {
+        hash = P_HashValue(hash, rng.seed[i]);
+    }
+
+    hashes[WH_RNG] = hash;
+    hash = 2166136261u;
+
+    for(i = 0; i < numsectors; i++) {
+        hash = P_HashValue(hash, sectors[i].floorheight);
+        hash = P_HashValue(hash, sectors[i].ceilingheight);
+        hash = P_HashValue(hash, sectors[i].special);
+    }
+
+    hashes[WH_SECTORS] = hash;
+    hash = 2166136261u;
+
+    for(i = 0; i < MAXPLAYERS; i++) {
+        player_t* player = &players[i];
+
+        if(!playeringame[i]) {
+            continue;
+        }
+
+        hash = P_HashValue(hash, player->playerstate);
+        hash = P_HashValue(hash, player->health);
+        hash = P_HashValue(hash, player->armorpoints);
+        hash = P_HashValue(hash, player->killcount);
+        hash = P_HashValue(hash, player->itemcount);
+        hash = P_HashValue(hash, player->secretcount);
+
+        for(j = 0; j < NUMAMMO; j++) {
+            hash = P_HashValue(hash, player->ammo[j]);
+        }
+    }
+
+    hashes[WH_PLAYERS] = hash;
+    hash = 2166136261u;
+
+    for(mo = mobjhead.next; mo != &mobjhead; mo = mo->next) {
+        hash = P_HashValue(hash, mo->type);
+        hash = P_HashValue(hash, mo->x);
+        hash = P_HashValue(hash, mo->y);
+        hash = P_HashValue(hash, mo->z);
+        hash = P_HashValue(hash, mo->momx);
+        hash = P_HashValue(hash, mo->momy);
+        hash = P_HashValue(hash, mo->momz);
+        hash = P_HashValue(hash, mo->angle);
+        hash = P_HashValue(hash, mo->health);
+        hash = P_HashValue(hash, (unsigned int)mo->flags);
+        hash = P_HashValue(hash, mo->state ? (int)(mo->state - states) : -1);
+        hash = P_HashValue(hash, mo->tics);
+    }
+
+    hashes[WH_MOBJS] = hash;
+}
+
+//
+// P_WorldHash
+//
+
+unsigned int P_WorldHash(void) {
+    unsigned int hashes[NUMWORLDHASHES];
+    unsigned int hash = 2166136261u;
+    int i;
+
+    P_WorldHashes(hashes);
+
+    for(i = 0; i < NUMWORLDHASHES; i++) {
+        hash = P_HashValue(hash, hashes[i]);
+    }
+
+    return hash;
+}
+
 //
 // P_Start
 //
@@ -434,11 +1030,25 @@ int P_Ticker(void) {
         }
     }
 
+    TRACE_BEGIN("P_RunThinkers");
     P_RunThinkers();
+    TRACE_END();
+
+    TRACE_BEGIN("P_ScanSights");
     P_ScanSights();
+    TRACE_END();
+
+    TRACE_BEGIN("P_RunMobjs");
     P_RunMobjs();
+    TRACE_END();
+
+    TRACE_BEGIN("P_UpdateSpecials");
     P_UpdateSpecials();
+    TRACE_END();
+
+    TRACE_BEGIN("P_RunMacros");
     P_RunMacros();
+    TRACE_END();
 
     ST_Ticker();
     AM_Ticker();
@@ -446,6 +1056,8 @@ int P_Ticker(void) {
     // for par times
     leveltime++;
 
+    P_CaptureSnapshot();
+
     return gameaction;
 }
 
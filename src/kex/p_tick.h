@@ -39,6 +39,20 @@ void P_Drawer(void);
 // Carries out all thinking of monsters and players.
 int P_Ticker(void);
 
+// Hash of the deterministic playsim state, for comparing runs
+unsigned int P_WorldHash(void);
+
+// The same state hashed one subsystem at a time
+enum {
+    WH_RNG,         // leveltime and the P_Random indexes
+    WH_SECTORS,
+    WH_PLAYERS,
+    WH_MOBJS,
+    NUMWORLDHASHES
+};
+
+void P_WorldHashes(unsigned int* hashes);
+
 
 
 #endif
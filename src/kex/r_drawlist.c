@@ -31,14 +31,19 @@
 #include "r_local.h"
 #include "gl_texture.h"
 #include "gl_main.h"
+#include "gl_shader.h"
 #include "r_drawlist.h"
 #include "i_system.h"
 #include "z_zone.h"
+#include "d_trace.h"
 
 static float envcolor[4] = { 0, 0, 0, 0 };
 
 drawlist_t drawlist[NUMDRAWLISTS];
 
+vtx_t *drawVertex = NULL;
+int drawVertexMax = 0;
+
 CVAR_EXTERNAL(r_texturecombiner);
 
 //
@@ -71,6 +76,24 @@ vtxlist_t *DL_AddVertexList(drawlist_t *dl) {
     return &dl->list[dl->index++];
 }
 
+//
+// DL_ReserveVertices
+// Makes sure drawVertex has room for count entries. Any
+// pointer into drawVertex is invalid after this call
+//
+
+void DL_ReserveVertices(int count) {
+    if(count <= drawVertexMax) {
+        return;
+    }
+
+    while(drawVertexMax < count) {
+        drawVertexMax *= 2;
+    }
+
+    drawVertex = (vtx_t*)Z_Realloc(drawVertex, drawVertexMax * sizeof(vtx_t), PU_STATIC, 0);
+}
+
 //
 // SortDrawList
 //
@@ -97,6 +120,15 @@ static int SortSprites(const vtxlist_t *a, const vtxlist_t *b) {
 // DL_ProcessDrawList
 //
 
+#ifdef USE_TRACE
+static const char *dl_tracenames[NUMDRAWLISTS] = {
+    "DL_ProcessDrawList WALL",
+    "DL_ProcessDrawList FLAT",
+    "DL_ProcessDrawList SPRITE",
+    "DL_ProcessDrawList AMAP"
+};
+#endif
+
 void DL_ProcessDrawList(int tag, dboolean(*procfunc)(vtxlist_t*, int*)) {
     drawlist_t* dl;
     int i;
@@ -105,12 +137,14 @@ void DL_ProcessDrawList(int tag, dboolean(*procfunc)(vtxlist_t*, int*)) {
     vtxlist_t* tail;
     dboolean checkNightmare = false;
 
-    if(tag < 0 && tag >= NUMDRAWLISTS) {
+    if(tag < 0 || tag >= NUMDRAWLISTS) {
         return;
     }
 
     dl = &drawlist[tag];
 
+    TRACE_BEGIN(dl_tracenames[tag]);
+
     if(dl->max > 0) {
         int palette = 0;
 
@@ -133,9 +167,11 @@ void DL_ProcessDrawList(int tag, dboolean(*procfunc)(vtxlist_t*, int*)) {
                 break;
             }
 
-            if(drawcount >= MAXDLDRAWCOUNT) {
-                I_Error("DL_ProcessDrawList: Draw overflow by %i, tag=%i", dl->index, tag);
-            }
+            //
+            // walls and sprites use four vertices, leafs
+            // reserve whatever extra they need themselves
+            //
+            DL_ReserveVertices(drawcount + 4);
 
             if(procfunc) {
                 if(!procfunc(head, &drawcount)) {
@@ -187,7 +223,10 @@ void DL_ProcessDrawList(int tag, dboolean(*procfunc)(vtxlist_t*, int*)) {
                                  head->flags & DLF_MIRRORT ? GL_MIRRORED_REPEAT : GL_REPEAT);
             }
 
-            if(r_texturecombiner.value > 0) {
+            if(gl_worldshader) {
+                GL_SetWorldShaderLight(head->params);
+            }
+            else if(r_texturecombiner.value > 0) {
                 envcolor[0] = envcolor[1] = envcolor[2] = ((float)head->params / 255.0f);
                 GL_SetEnvColor(envcolor);
             }
@@ -197,10 +236,12 @@ void DL_ProcessDrawList(int tag, dboolean(*procfunc)(vtxlist_t*, int*)) {
                 GL_UpdateEnvTexture(D_RGBA(l, l, l, 0xff));
             }
 
+            // drawVertex may have moved while growing
+            dglSetVertex(drawVertex);
             dglDrawGeometry(drawcount, drawVertex);
 
             // count vertex size
-            if(devparm) {
+            if(devparm || timingdemo) {
                 vertCount += drawcount;
             }
 
@@ -208,6 +249,8 @@ void DL_ProcessDrawList(int tag, dboolean(*procfunc)(vtxlist_t*, int*)) {
             head->data = NULL;
         }
     }
+
+    TRACE_END();
 }
 
 //
@@ -254,6 +297,11 @@ void DL_Init(void) {
     drawlist_t *dl;
     int i;
 
+    if(!drawVertex) {
+        drawVertexMax = MINDLDRAWCOUNT;
+        drawVertex = (vtx_t*)Z_Malloc(drawVertexMax * sizeof(vtx_t), PU_STATIC, 0);
+    }
+
     for(i = 0; i < NUMDRAWLISTS; i++) {
         dl = &drawlist[i];
 
@@ -61,8 +61,12 @@ typedef struct {
 
 extern drawlist_t drawlist[NUMDRAWLISTS];
 
-#define MAXDLDRAWCOUNT  0x10000
-vtx_t drawVertex[MAXDLDRAWCOUNT];
+#define MINDLDRAWCOUNT  0x10000
+
+extern vtx_t *drawVertex;
+extern int drawVertexMax;
+
+void DL_ReserveVertices(int count);
 
 dboolean DL_ProcessWalls(vtxlist_t* vl, int* drawcount);
 dboolean DL_ProcessLeafs(vtxlist_t* vl, int* drawcount);
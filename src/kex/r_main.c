@@ -47,6 +47,7 @@
 #include "r_drawlist.h"
 #include "gl_draw.h"
 #include "g_actions.h"
+#include "d_trace.h"
 
 lumpinfo_t      *lumpinfo;
 int             skytexture;
@@ -77,9 +78,18 @@ int             vertCount = 0;
 unsigned int    renderTic = 0;
 unsigned int    spriteRenderTic = 0;
 unsigned int    glBindCalls = 0;
+unsigned int    glDrawCalls = 0;
 
 dboolean        bRenderSky = false;
 
+// [kex] point lookup grid, see R_BuildPointGrid
+int*            pointgrid = NULL;
+fixed_t         pointgridorgx;
+fixed_t         pointgridorgy;
+int             pointgridwidth;
+int             pointgridheight;
+int             pointgridshift;
+
 CVAR(r_fov, 74.0);
 CVAR(r_fillmode, 1);
 CVAR(r_uniformtime, 0);
@@ -112,6 +122,7 @@ CVAR_CMD(r_anisotropic, 0) {
 }
 
 CVAR_EXTERNAL(r_texturecombiner);
+CVAR_EXTERNAL(r_glsl);
 CVAR_EXTERNAL(i_interpolateframes);
 CVAR_EXTERNAL(p_usecontext);
 
@@ -130,6 +141,151 @@ static CMD(Wireframe) {
     R_DrawWireframe(b);
 }
 
+//
+// R_PointInSubsectorBSP
+// Full walk from the root; what the grid must agree with
+//
+
+static subsector_t* R_PointInSubsectorBSP(fixed_t x, fixed_t y) {
+    int nodenum;
+
+    if(!numnodes) {
+        return subsectors;
+    }
+
+    nodenum = numnodes-1;
+
+    while(!(nodenum & NF_SUBSECTOR)) {
+        nodenum = nodes[nodenum].children[R_PointOnSide(x, y, &nodes[nodenum])];
+    }
+
+    return &subsectors[nodenum & ~NF_SUBSECTOR];
+}
+
+//
+// CMD_TestPointGrid
+// Checks the grid against a full BSP walk at every step
+// map units (default 1) across the map, and just around
+// every partition origin where rounding is touchiest
+//
+
+static CMD(TestPointGrid) {
+    fixed_t x;
+    fixed_t y;
+    fixed_t maxx;
+    fixed_t maxy;
+    int     step = 1;
+    int     i;
+    int     j;
+    int     count = 0;
+    int     bad = 0;
+
+    if(gamestate != GS_LEVEL || !pointgrid) {
+        return;
+    }
+
+    if(param[0]) {
+        step = datoi(param[0]);
+
+        if(step <= 0) {
+            return;
+        }
+    }
+
+    maxx = pointgridorgx + (pointgridwidth << pointgridshift);
+    maxy = pointgridorgy + (pointgridheight << pointgridshift);
+
+    for(y = pointgridorgy; y < maxy; y += step * FRACUNIT) {
+        for(x = pointgridorgx; x < maxx; x += step * FRACUNIT) {
+            if(R_PointInSubsector(x, y) != R_PointInSubsectorBSP(x, y)) {
+                bad++;
+            }
+            count++;
+        }
+    }
+
+    for(i = 0; i < numnodes; i++) {
+        for(j = 0; j < 9; j++) {
+            x = nodes[i].x + (j % 3) - 1;
+            y = nodes[i].y + (j / 3) - 1;
+
+            if(R_PointInSubsector(x, y) != R_PointInSubsectorBSP(x, y)) {
+                bad++;
+            }
+            count++;
+        }
+    }
+
+    CON_Printf(bad ? RED : WHITE, "Point grid: %i mismatches in %i points\n", bad, count);
+}
+
+//
+// CMD_BenchPointGrid
+// Times lookups at random points within the map bounds,
+// grid against a full BSP walk from the root
+//
+
+static CMD(BenchPointGrid) {
+    fixed_t*        pts;
+    fixed_t         w;
+    fixed_t         h;
+    unsigned int    seed = 0x1d872b41;
+    int             count = 1000000;
+    int             i;
+    int             sum = 0;
+    uint64          start;
+    uint64          bsptime;
+    uint64          gridtime;
+
+    if(gamestate != GS_LEVEL || !pointgrid) {
+        return;
+    }
+
+    if(param[0]) {
+        count = datoi(param[0]);
+
+        if(count <= 0) {
+            return;
+        }
+    }
+
+    pts = (fixed_t*)Z_Malloc(sizeof(fixed_t) * count * 2, PU_STATIC, 0);
+    w = pointgridwidth << pointgridshift;
+    h = pointgridheight << pointgridshift;
+
+    for(i = 0; i < count; i++) {
+        // xorshift; leaves the game's random tables alone
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        pts[i*2+0] = pointgridorgx + (fixed_t)(seed % (unsigned int)w);
+
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        pts[i*2+1] = pointgridorgy + (fixed_t)(seed % (unsigned int)h);
+    }
+
+    start = I_GetTimeUS();
+    for(i = 0; i < count; i++) {
+        sum += R_PointInSubsectorBSP(pts[i*2+0], pts[i*2+1]) - subsectors;
+    }
+    bsptime = I_GetTimeUS() - start;
+
+    start = I_GetTimeUS();
+    for(i = 0; i < count; i++) {
+        sum -= R_PointInSubsector(pts[i*2+0], pts[i*2+1]) - subsectors;
+    }
+    gridtime = I_GetTimeUS() - start;
+
+    Z_Free(pts);
+
+    CON_Printf(WHITE, "BSP walk: %i points, %.3f us each\n", count, (float)bsptime / count);
+    CON_Printf(WHITE, "Grid: %i points, %.3f us each (%ix%i cells)%s\n",
+               count, (float)gridtime / count, pointgridwidth, pointgridheight,
+               sum ? ", results differ!" : "");
+}
+
 //
 // R_PointToAngle
 // To get a global angle from cartesian coordinates,
@@ -293,6 +449,9 @@ void R_Init(void) {
     GL_ResetTextures();
 
     G_AddCommand("wireframe", CMD_Wireframe, 0);
+    G_AddCommand("testpointgrid", CMD_TestPointGrid, 0);
+    G_AddCommand("benchpointgrid", CMD_BenchPointGrid, 0);
+    G_AddCommand("testfire", CMD_TestFire, 0);
 }
 
 //
@@ -303,6 +462,8 @@ subsector_t* R_PointInSubsector(fixed_t x, fixed_t y) {
     node_t*    node;
     int        side;
     int        nodenum;
+    int        cx;
+    int        cy;
 
     // single subsector is a special case
     if(!numnodes) {
@@ -311,6 +472,16 @@ subsector_t* R_PointInSubsector(fixed_t x, fixed_t y) {
 
     nodenum = numnodes-1;
 
+    // start from the deepest node known to contain the whole cell
+    if(pointgrid && x >= pointgridorgx && y >= pointgridorgy) {
+        cx = ((unsigned int)x - pointgridorgx) >> pointgridshift;
+        cy = ((unsigned int)y - pointgridorgy) >> pointgridshift;
+
+        if(cx < pointgridwidth && cy < pointgridheight) {
+            nodenum = pointgrid[cy * pointgridwidth + cx];
+        }
+    }
+
     while(!(nodenum & NF_SUBSECTOR)) {
         node = &nodes[nodenum];
         side = R_PointOnSide(x, y, node);
@@ -320,6 +491,118 @@ subsector_t* R_PointInSubsector(fixed_t x, fixed_t y) {
     return &subsectors[nodenum & ~NF_SUBSECTOR];
 }
 
+//
+// R_CellNode
+// Descends the BSP for as long as every point of the cell
+// [x1,x2]x[y1,y2] falls on the same side of each partition.
+//
+// R_PointOnSide compares two rounded products, one stepping
+// with x and the other with y, so the side can only change
+// monotonically across the cell and the four corners decide it
+// for every point inside. The sign bit shortcut breaks that when
+// dx or dy changes sign inside the cell, so a cell straddling the
+// partition's origin row or column stops at that node.
+// testpointgrid checks the result against the plain walk.
+//
+
+static int R_CellNode(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2) {
+    node_t* node;
+    int     nodenum;
+    int     side;
+
+    nodenum = numnodes-1;
+
+    while(!(nodenum & NF_SUBSECTOR)) {
+        node = &nodes[nodenum];
+
+        if(node->dx && node->dy &&
+                ((((unsigned int)x1 - node->x) ^ ((unsigned int)x2 - node->x)) & 0x80000000 ||
+                 (((unsigned int)y1 - node->y) ^ ((unsigned int)y2 - node->y)) & 0x80000000)) {
+            break;
+        }
+
+        side = R_PointOnSide(x1, y1, node);
+
+        if(R_PointOnSide(x2, y1, node) != side ||
+                R_PointOnSide(x1, y2, node) != side ||
+                R_PointOnSide(x2, y2, node) != side) {
+            break;
+        }
+
+        nodenum = node->children[side];
+    }
+
+    return nodenum;
+}
+
+//
+// R_BuildPointGrid
+// Called by P_SetupLevel once the nodes are loaded
+//
+
+#define POINTGRIDSHIFT  (6+FRACBITS)    // 64 unit cells
+#define POINTGRIDMAX    (1<<20)
+
+void R_BuildPointGrid(void) {
+    fixed_t minx;
+    fixed_t miny;
+    fixed_t maxx;
+    fixed_t maxy;
+    fixed_t x;
+    fixed_t y;
+    int     i;
+    int     cx;
+    int     cy;
+    int     size;
+
+    pointgrid = NULL;
+
+    if(!numnodes || !numvertexes) {
+        return;
+    }
+
+    minx = maxx = vertexes[0].x;
+    miny = maxy = vertexes[0].y;
+
+    for(i = 1; i < numvertexes; i++) {
+        if(vertexes[i].x < minx) {
+            minx = vertexes[i].x;
+        }
+        if(vertexes[i].x > maxx) {
+            maxx = vertexes[i].x;
+        }
+        if(vertexes[i].y < miny) {
+            miny = vertexes[i].y;
+        }
+        if(vertexes[i].y > maxy) {
+            maxy = vertexes[i].y;
+        }
+    }
+
+    pointgridorgx = minx;
+    pointgridorgy = miny;
+    pointgridshift = POINTGRIDSHIFT;
+
+    // grow the cells on huge maps
+    do {
+        pointgridwidth = (((unsigned int)maxx - minx) >> pointgridshift) + 1;
+        pointgridheight = (((unsigned int)maxy - miny) >> pointgridshift) + 1;
+    } while(pointgridwidth * pointgridheight > POINTGRIDMAX && ++pointgridshift);
+
+    size = 1 << pointgridshift;
+
+    pointgrid = Z_Malloc(sizeof(int) * pointgridwidth * pointgridheight, PU_LEVEL, &pointgrid);
+
+    for(cy = 0; cy < pointgridheight; cy++) {
+        y = pointgridorgy + cy * size;
+
+        for(cx = 0; cx < pointgridwidth; cx++) {
+            x = pointgridorgx + cx * size;
+            pointgrid[cy * pointgridwidth + cx] = R_CellNode(x, y, x + size - 1, y + size - 1);
+        }
+    }
+}
+
 //
 // R_SetViewAngleOffset
 //
@@ -363,6 +646,11 @@ void R_PrecacheLevel(void) {
     int num;
     mobj_t* mo;
 
+    // no GL context to upload to
+    if(nodrawparm) {
+        return;
+    }
+
     CON_DPrintf("--------R_PrecacheLevel--------\n");
     GL_DumpTextures();
 
@@ -818,6 +1106,11 @@ void R_RenderPlayerView(player_t *player) {
     //
     R_ClearSprites();
 
+    //
+    // group things by subsector for R_AddSprites
+    //
+    P_GroupMobjSlots();
+
     //
     // setup draw frame
     //
@@ -836,7 +1129,9 @@ void R_RenderPlayerView(player_t *player) {
     // draw sky
     //
     if(bRenderSky) {
+        TRACE_BEGIN("R_DrawSky");
         R_DrawSky();
+        TRACE_END();
     }
 
     bRenderSky = false;
@@ -866,7 +1161,9 @@ void R_RenderPlayerView(player_t *player) {
     //
     // traverse BSP for rendering
     //
+    TRACE_BEGIN("R_RenderBSPNode");
     R_RenderBSPNode(numnodes-1);
+    TRACE_END();
 
     //
     // check for new console commands
@@ -937,6 +1234,7 @@ void R_RegisterCvars(void) {
     CON_CvarRegister(&r_drawblockmap);
     CON_CvarRegister(&r_drawtrace);
     CON_CvarRegister(&r_texturecombiner);
+    CON_CvarRegister(&r_glsl);
     CON_CvarRegister(&r_rendersprites);
     CON_CvarRegister(&r_texnonpowresize);
     CON_CvarRegister(&r_drawfill);
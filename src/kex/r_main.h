@@ -55,6 +55,7 @@ extern int          vertCount;
 extern unsigned int renderTic;
 extern unsigned int spriteRenderTic;
 extern unsigned int glBindCalls;
+extern unsigned int glDrawCalls;
 
 extern dboolean     bRenderSky;
 
@@ -66,6 +67,7 @@ CVAR_EXTERNAL(r_drawtrace);
 void R_Init(void);
 void R_RenderPlayerView(player_t *player);
 subsector_t *R_PointInSubsector(fixed_t x, fixed_t y);
+void R_BuildPointGrid(void);
 angle_t R_PointToAngle2(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2);
 angle_t R_PointToAngle(fixed_t x, fixed_t y);//note difference from sw version
 angle_t R_PointToPitch(fixed_t z1, fixed_t z2, fixed_t dist);
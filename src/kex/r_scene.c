@@ -28,6 +28,7 @@
 #include "doomstat.h"
 #include "gl_main.h"
 #include "gl_texture.h"
+#include "gl_shader.h"
 #include "r_local.h"
 #include "r_sky.h"
 #include "r_drawlist.h"
@@ -82,6 +83,8 @@ static dboolean ProcessFlats(vtxlist_t* vl, int* drawcount) {
     sector  = ss->sector;
     count   = *drawcount;
 
+    DL_ReserveVertices(count + ss->numleafs);
+
     for(j = 0; j < ss->numleafs - 2; j++) {
         dglTriangle(count, count + 1 + j, count + 2 + j);
     }
@@ -204,14 +207,17 @@ static dboolean ProcessSprites(vtxlist_t* vl, int* drawcount) {
 // Sky flats determine how fog is rendered. this includes
 // fog color, distance and density. The factor for fog
 // density is based on values from the original N64 version.
+// Returns the fog mode that was set up, or 0 if fog is off
 //
 
-static void SetupFog(void) {
+static int SetupFog(void) {
+    int mode = 0;
+
     dglFogi(GL_FOG_MODE, GL_LINEAR);
 
     // don't render fog in wireframe mode
     if(r_fillmode.value <= 0) {
-        return;
+        return 0;
     }
 
     if(!skyflatnum) {
@@ -247,6 +253,7 @@ static void SetupFog(void) {
             fogcolor = sky->fogcolor;
             dglFogi(GL_FOG_MODE, GL_EXP);
             dglFogf(GL_FOG_DENSITY, 14.0f / (max + min));
+            mode = GL_EXP;
         }
         // do linear rendering for colored fog
         else {
@@ -265,11 +272,14 @@ static void SetupFog(void) {
 
             dglFogf(GL_FOG_START, min);
             dglFogf(GL_FOG_END, max);
+            mode = GL_LINEAR;
         }
 
         dglGetColorf(fogcolor, color);
         dglFogfv(GL_FOG_COLOR, color);
     }
+
+    return mode;
 }
 
 //
@@ -292,36 +302,44 @@ void R_SetViewMatrix(void) {
 //
 
 void R_RenderWorld(void) {
-    SetupFog();
+    int fogmode = SetupFog();
 
     dglEnable(GL_DEPTH_TEST);
 
-    DL_BeginDrawList(r_fillmode.value >= 1, r_texturecombiner.value >= 1);
+    if(GL_CanUseWorldShader()) {
+        DL_BeginDrawList(true, false);
 
-    // setup texture environment for effects
-    if(r_texturecombiner.value) {
-        if(!nolights) {
-            GL_UpdateEnvTexture(WHITE);
-            GL_SetTextureUnit(1, true);
-            dglTexCombModulate(GL_PREVIOUS, GL_PRIMARY_COLOR);
-        }
+        // sector light, flash and fog are all handled by the shader
+        GL_BindWorldShader(!nolights, st_flashoverlay.value <= 0 ? flashcolor : 0, fogmode);
+    }
+    else {
+        DL_BeginDrawList(r_fillmode.value >= 1, r_texturecombiner.value >= 1);
+
+        // setup texture environment for effects
+        if(r_texturecombiner.value) {
+            if(!nolights) {
+                GL_UpdateEnvTexture(WHITE);
+                GL_SetTextureUnit(1, true);
+                dglTexCombModulate(GL_PREVIOUS, GL_PRIMARY_COLOR);
+            }
 
-        if(st_flashoverlay.value <= 0) {
-            GL_SetTextureUnit(2, true);
-            dglTexCombColor(GL_PREVIOUS, flashcolor, GL_ADD);
-        }
+            if(st_flashoverlay.value <= 0) {
+                GL_SetTextureUnit(2, true);
+                dglTexCombColor(GL_PREVIOUS, flashcolor, GL_ADD);
+            }
 
-        dglTexCombReplaceAlpha(GL_TEXTURE0_ARB);
+            dglTexCombReplaceAlpha(GL_TEXTURE0_ARB);
 
-        GL_SetTextureUnit(0, true);
-    }
-    else {
-        GL_SetTextureUnit(1, true);
-        GL_SetTextureMode(GL_ADD);
-        GL_SetTextureUnit(0, true);
+            GL_SetTextureUnit(0, true);
+        }
+        else {
+            GL_SetTextureUnit(1, true);
+            GL_SetTextureMode(GL_ADD);
+            GL_SetTextureUnit(0, true);
 
-        if(nolights) {
-            GL_SetTextureMode(GL_REPLACE);
+            if(nolights) {
+                GL_SetTextureMode(GL_REPLACE);
+            }
         }
     }
 
@@ -353,6 +371,8 @@ void R_RenderWorld(void) {
 
     // -------------- Restore states -----------------------------
 
+    GL_UnbindWorldShader();
+
     dglDisable(GL_ALPHA_TEST);
     dglDepthMask(GL_TRUE);
     dglDisable(GL_FOG);
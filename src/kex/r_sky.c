@@ -27,6 +27,7 @@
 //-----------------------------------------------------------------------------
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "doomstat.h"
 #include "r_lights.h"
@@ -43,6 +44,8 @@
 #include "gl_texture.h"
 #include "gl_draw.h"
 #include "r_drawlist.h"
+#include "g_actions.h"
+#include "con_console.h"
 
 skydef_t*   sky;
 int         skypicnum = -1;
@@ -142,12 +145,42 @@ static void R_TitleSkyTicker(void) {
 }
 
 //
-// R_DrawSkyDome
+// SKY DOME CACHE
+//
+// Dome geometry only depends on its shape parameters so it is
+// built once and kept around. Per frame only the vertex colors
+// are touched, and only when they have changed.
 //
 
-static void R_DrawSkyDome(int tiles, float rows, int height,
-                          int radius, float offset, float topoffs,
-                          rcolor c1, rcolor c2) {
+#define NUM_SKY_DOME_FACES  32
+
+typedef enum {
+    SKYDOME_FIRE,
+    SKYDOME_PIC,
+    SKYDOME_BACKDROP,
+    NUMSKYDOMES
+} skydometype_t;
+
+typedef struct {
+    int         tiles;
+    float       rows;
+    int         height;
+    int         radius;
+    float       topoffs;
+    rcolor      c1;
+    rcolor      c2;
+    dboolean    valid;
+    vtx_t       vtx[NUM_SKY_DOME_FACES * 4];
+} skydome_t;
+
+static skydome_t skydomes[NUMSKYDOMES];
+
+//
+// R_BuildSkyDome
+//
+
+static void R_BuildSkyDome(skydome_t *dome, int tiles, float rows, int height,
+                           int radius, float topoffs) {
     fixed_t x, y, z;
     fixed_t lx, ly;
     int i;
@@ -155,50 +188,18 @@ static void R_DrawSkyDome(int tiles, float rows, int height,
     float tu1, tu2;
     int r;
     vtx_t *vtx;
-    int count;
-
-    lx = ly = count = 0;
 
-#define NUM_SKY_DOME_FACES  32
+    lx = ly = 0;
 
-    //
-    // hack to force ortho scale back to 1
-    //
-    GL_SetOrthoScale(1.0f);
-
-    //
-    // setup view projection
-    //
-    dglMatrixMode(GL_PROJECTION);
-    dglLoadIdentity();
-    dglViewFrustum(video_width, video_height, r_fov.value, 0.1f);
-    dglMatrixMode(GL_MODELVIEW);
-    dglLoadIdentity();
-    dglPushMatrix();
-    dglRotatef(-TRUEANGLES(viewpitch), 1.0f, 0.0f, 0.0f);
-    dglRotatef(-TRUEANGLES(viewangle) + 90.0f, 0.0f, 0.0f, 1.0f);
-
-    //
-    // try to center view to the dome
-    //
-    dglTranslated(
-        -((float)radius / ((float)NUM_SKY_DOME_FACES / 2.0f)),
-        -((float)radius / (M_PI / 2)),
-        -offset);
-
-    //
-    // front faces are drawn here, so cull the back faces
-    //
-    dglCullFace(GL_BACK);
-    GL_SetState(GLSTATE_BLEND, 1);
+    dome->tiles     = tiles;
+    dome->rows      = rows;
+    dome->height    = height;
+    dome->radius    = radius;
+    dome->topoffs   = topoffs;
+    dome->valid     = true;
 
     r = radius / (NUM_SKY_DOME_FACES / 4);
-
-    //
-    // set pointer for the main vertex list
-    //
-    dglSetVertex(drawVertex);
-    vtx = drawVertex;
+    vtx = dome->vtx;
 
 #define SKYDOME_VERTEX() vtx->x = F2D3D(x); vtx->y = F2D3D(y); vtx->z = F2D3D(z)
 #define SKYDOME_UV(u, v) vtx->tu = u; vtx->tv = v
@@ -228,11 +229,6 @@ static void R_DrawSkyDome(int tiles, float rows, int height,
     for(i = 0; i < NUM_SKY_DOME_FACES; i++) {
         angle_t angle = an * i;
 
-        dglSetVertexColor(&vtx[0], c2, 1);
-        dglSetVertexColor(&vtx[1], c1, 1);
-        dglSetVertexColor(&vtx[2], c1, 1);
-        dglSetVertexColor(&vtx[3], c2, 1);
-
         SKYDOME_LEFT(rows, -height);
         SKYDOME_LEFT(topoffs, height);
         SKYDOME_RIGHT(topoffs, height);
@@ -241,28 +237,137 @@ static void R_DrawSkyDome(int tiles, float rows, int height,
         lx = x;
         ly = y;
 
+        tu1 += tu2;
+    }
+
+    //
+    // force colors to be set on the next draw
+    //
+    dome->c1 = dome->c2 = 0;
+    dglSetVertexColor(dome->vtx, 0, NUM_SKY_DOME_FACES * 4);
+
+#undef SKYDOME_RIGHT
+#undef SKYDOME_LEFT
+#undef SKYDOME_UV
+#undef SKYDOME_VERTEX
+}
+
+//
+// R_InitSkyDomes
+// Called from P_SetupSky whenever a new sky is set up.
+// The backdrop dome depends on the texture dimensions so
+// that one is built on its first draw instead
+//
+
+void R_InitSkyDomes(void) {
+    int i;
+
+    for(i = 0; i < NUMSKYDOMES; i++) {
+        skydomes[i].valid = false;
+    }
+
+    if(!sky) {
+        return;
+    }
+
+    if(sky->flags & SKF_FIRE) {
+        R_BuildSkyDome(&skydomes[SKYDOME_FIRE], 16, 1, 1024, 4096, 0.0075f);
+    }
+
+    if(skypicnum >= 0 && !(sky->flags & SKF_CLOUD)) {
+        R_BuildSkyDome(&skydomes[SKYDOME_PIC], 4, 2, 512, 1024, 0);
+    }
+}
+
+//
+// R_DrawSkyDome
+//
+
+static void R_DrawSkyDome(skydometype_t type, int tiles, float rows, int height,
+                          int radius, float offset, float topoffs,
+                          rcolor c1, rcolor c2) {
+    skydome_t *dome;
+    int i;
+    int count;
+
+    dome = &skydomes[type];
+
+    if(!dome->valid ||
+            dome->tiles != tiles ||
+            dome->rows != rows ||
+            dome->height != height ||
+            dome->radius != radius ||
+            dome->topoffs != topoffs) {
+        R_BuildSkyDome(dome, tiles, rows, height, radius, topoffs);
+    }
+
+    //
+    // update colors only if they've changed (thunder)
+    //
+    if(dome->c1 != c1 || dome->c2 != c2) {
+        vtx_t *vtx = dome->vtx;
+
+        for(i = 0; i < NUM_SKY_DOME_FACES; i++, vtx += 4) {
+            dglSetVertexColor(&vtx[0], c2, 1);
+            dglSetVertexColor(&vtx[1], c1, 1);
+            dglSetVertexColor(&vtx[2], c1, 1);
+            dglSetVertexColor(&vtx[3], c2, 1);
+        }
+
+        dome->c1 = c1;
+        dome->c2 = c2;
+    }
+
+    //
+    // hack to force ortho scale back to 1
+    //
+    GL_SetOrthoScale(1.0f);
+
+    //
+    // setup view projection
+    //
+    dglMatrixMode(GL_PROJECTION);
+    dglLoadIdentity();
+    dglViewFrustum(video_width, video_height, r_fov.value, 0.1f);
+    dglMatrixMode(GL_MODELVIEW);
+    dglLoadIdentity();
+    dglPushMatrix();
+    dglRotatef(-TRUEANGLES(viewpitch), 1.0f, 0.0f, 0.0f);
+    dglRotatef(-TRUEANGLES(viewangle) + 90.0f, 0.0f, 0.0f, 1.0f);
+
+    //
+    // try to center view to the dome
+    //
+    dglTranslated(
+        -((float)radius / ((float)NUM_SKY_DOME_FACES / 2.0f)),
+        -((float)radius / (M_PI / 2)),
+        -offset);
+
+    //
+    // front faces are drawn here, so cull the back faces
+    //
+    dglCullFace(GL_BACK);
+    GL_SetState(GLSTATE_BLEND, 1);
+
+    //
+    // set pointer for the cached vertex list
+    //
+    dglSetVertex(dome->vtx);
+
+    for(i = 0, count = 0; i < NUM_SKY_DOME_FACES; i++, count += 4) {
         dglTriangle(0+count, 1+count, 2+count);
         dglTriangle(3+count, 0+count, 2+count);
-        count += 4;
-
-        tu1 += tu2;
     }
 
     //
     // draw sky dome
     //
-    dglDrawGeometry(count, drawVertex);
+    dglDrawGeometry(count, dome->vtx);
 
     dglPopMatrix();
     dglCullFace(GL_FRONT);
 
     GL_SetState(GLSTATE_BLEND, 0);
-
-#undef SKYDOME_RIGHT
-#undef SKYDOME_LEFT
-#undef SKYDOME_UV
-#undef SKYDOME_VERTEX
-#undef NUM_SKY_DOME_FACES
 }
 
 //
@@ -575,10 +680,79 @@ static void R_DrawClouds(void) {
 }
 
 //
-// R_SpreadFire
+// R_Fire
+//
+// Each pixel spreads into a random neighbor on the row above it.
+// Columns are processed left to right, top to bottom, since a
+// column writes into the next column's rows before that column
+// reads them back, and the rndtable index only advances on lit
+// pixels. Changing that order would change the output.
+//
+
+static int fireDirtyLow = 0;    // first row changed since the last upload
+static int fireDirtyHigh = -1;  // last row changed since the last upload
+
+static void R_Fire(byte *buffer, int rand) {
+    int x;
+    int y;
+    int low = FIRESKY_HEIGHT;
+    int high = -1;
+
+    for(x = 0; x < FIRESKY_WIDTH; x++) {
+        byte *src = buffer + FIRESKY_WIDTH + x;
+        byte *row = buffer;
+
+        for(y = 0; y < FIRESKY_HEIGHT - 1; y++) {
+            byte *dst;
+            byte pixel = *src;
+
+            if(pixel) {
+                int randIdx = rndtable[rand];
+
+                rand = ((rand + 2) & 0xff);
+                dst = row + (((x - (randIdx & 3)) + 1) & (FIRESKY_WIDTH-1));
+                pixel -= (randIdx & 1);
+            }
+            else {
+                dst = row + x;
+            }
+
+            if(*dst != pixel) {
+                *dst = pixel;
+
+                if(y < low) {
+                    low = y;
+                }
+
+                if(y > high) {
+                    high = y;
+                }
+            }
+
+            src += FIRESKY_WIDTH;
+            row += FIRESKY_WIDTH;
+        }
+    }
+
+    if(high < 0) {
+        return;
+    }
+
+    if(low < fireDirtyLow || fireDirtyHigh < fireDirtyLow) {
+        fireDirtyLow = low;
+    }
+
+    if(high > fireDirtyHigh) {
+        fireDirtyHigh = high;
+    }
+}
+
+//
+// R_SpreadFireOld
+// The original fire kernel, kept as the reference for testfire
 //
 
-static void R_SpreadFire(byte* src1, byte* src2, int pixel, int counter, int* rand) {
+static void R_SpreadFireOld(byte* src1, byte* src2, int pixel, int counter, int* rand) {
     int randIdx = 0;
     byte *tmpSrc;
 
@@ -595,18 +769,16 @@ static void R_SpreadFire(byte* src1, byte* src2, int pixel, int counter, int* ra
 }
 
 //
-// R_Fire
+// R_FireOld
 //
 
-static void R_Fire(byte *buffer) {
+static void R_FireOld(byte *buffer, int rand) {
     int counter = 0;
-    int rand = 0;
     int step = 0;
     int pixel = 0;
     byte *src;
     byte *srcoffset;
 
-    rand = (M_Random() & 0xff);
     src = buffer;
     counter = 0;
     src += FIRESKY_WIDTH;
@@ -617,7 +789,7 @@ static void R_Fire(byte *buffer) {
 
         step = 2;
 
-        R_SpreadFire(src, srcoffset, pixel, counter, &rand);
+        R_SpreadFireOld(src, srcoffset, pixel, counter, &rand);
 
         src += FIRESKY_WIDTH;
         srcoffset += FIRESKY_WIDTH;
@@ -626,13 +798,13 @@ static void R_Fire(byte *buffer) {
             pixel = *(byte*)srcoffset;
             step += 2;
 
-            R_SpreadFire(src, srcoffset, pixel, counter, &rand);
+            R_SpreadFireOld(src, srcoffset, pixel, counter, &rand);
 
             pixel = *(byte*)(srcoffset + FIRESKY_WIDTH);
             src += FIRESKY_WIDTH;
             srcoffset += FIRESKY_WIDTH;
 
-            R_SpreadFire(src, srcoffset, pixel, counter, &rand);
+            R_SpreadFireOld(src, srcoffset, pixel, counter, &rand);
 
             src += FIRESKY_WIDTH;
             srcoffset += FIRESKY_WIDTH;
@@ -647,6 +819,93 @@ static void R_Fire(byte *buffer) {
     while(counter < FIRESKY_WIDTH);
 }
 
+//
+// CMD_TestFire
+// Runs the old and new kernels side by side from count (default
+// 200) starting buffers, 500 steps each with the same seeds, and
+// compares the buffers byte for byte. Every row that changed must
+// also fall inside the dirty range R_Fire reports
+//
+
+CMD(TestFire) {
+    byte            oldbuf[FIRESKY_WIDTH * FIRESKY_HEIGHT];
+    byte            newbuf[FIRESKY_WIDTH * FIRESKY_HEIGHT];
+    byte            prev[FIRESKY_WIDTH * FIRESKY_HEIGHT];
+    unsigned int    seed = 0x6b8b4567;
+    int             count = 200;
+    int             steps = 0;
+    int             bad = 0;
+    int             missed = 0;
+    int             i;
+    int             j;
+    int             k;
+
+    if(param[0]) {
+        count = datoi(param[0]);
+
+        if(count <= 0) {
+            return;
+        }
+    }
+
+    for(i = 0; i < count; i++) {
+        // odd runs start from noise, even ones from a lit bottom row
+        for(k = 0; k < FIRESKY_WIDTH * FIRESKY_HEIGHT; k++) {
+            // xorshift; leaves the game's random tables alone
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+
+            if(i & 1) {
+                oldbuf[k] = seed & 15;
+            }
+            else {
+                oldbuf[k] = (k >= FIRESKY_WIDTH * (FIRESKY_HEIGHT - 1)) ? 15 : 0;
+            }
+        }
+
+        dmemcpy(newbuf, oldbuf, sizeof(newbuf));
+
+        for(j = 0; j < 500; j++) {
+            int rand;
+
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            rand = seed & 0xff;
+
+            dmemcpy(prev, newbuf, sizeof(prev));
+            fireDirtyLow = 0;
+            fireDirtyHigh = -1;
+
+            R_FireOld(oldbuf, rand);
+            R_Fire(newbuf, rand);
+            steps++;
+
+            if(memcmp(oldbuf, newbuf, sizeof(newbuf))) {
+                bad++;
+                break;
+            }
+
+            for(k = 0; k < FIRESKY_WIDTH * FIRESKY_HEIGHT; k++) {
+                if(prev[k] != newbuf[k] &&
+                        (k / FIRESKY_WIDTH < fireDirtyLow || k / FIRESKY_WIDTH > fireDirtyHigh)) {
+                    missed++;
+                    break;
+                }
+            }
+        }
+    }
+
+    // the sky texture has to be uploaded in full again
+    fireDirtyLow = 0;
+    fireDirtyHigh = FIRESKY_HEIGHT - 1;
+
+    CON_Printf((bad || missed) ? RED : WHITE,
+               "Fire: %i of %i runs differ, %i steps missed a changed row (%i steps)\n",
+               bad, count, missed, steps);
+}
+
 //
 // R_InitFire
 //
@@ -671,6 +930,9 @@ void R_InitFire(void) {
     for(i = 0; i < 4096; i++) {
         fireBuffer[i] >>= 4;
     }
+
+    fireDirtyLow = 0;
+    fireDirtyHigh = FIRESKY_HEIGHT - 1;
 }
 
 //
@@ -679,7 +941,7 @@ void R_InitFire(void) {
 
 static void R_FireTicker(void) {
     if(leveltime & 1) {
-        R_Fire(fireBuffer);
+        R_Fire(fireBuffer, M_Random() & 0xff);
     }
 }
 
@@ -693,11 +955,16 @@ static void R_DrawFire(void) {
     dtexture t = gfxptr[fireLump];
     int i;
 
+    // texture was never created or has been dumped
+    if(!t) {
+        fireDirtyLow = 0;
+        fireDirtyHigh = FIRESKY_HEIGHT - 1;
+    }
+
     //
-    // copy fire pixel data to texture data array
+    // copy changed rows of fire pixel data to texture data array
     //
-    dmemset(firetexture, 0, sizeof(int) * FIRESKY_WIDTH * FIRESKY_HEIGHT);
-    for(i = 0; i < FIRESKY_WIDTH * FIRESKY_HEIGHT; i++) {
+    for(i = fireDirtyLow * FIRESKY_WIDTH; i < (fireDirtyHigh + 1) * FIRESKY_WIDTH; i++) {
         byte rgb[3];
 
         rgb[0] = firePal16[fireBuffer[i]].r;
@@ -712,10 +979,12 @@ static void R_DrawFire(void) {
     }
 
     dglBindTexture(GL_TEXTURE_2D, gfxptr[fireLump]);
+    GL_ResetTextures();
+    curgfx = fireLump;
     GL_CheckFillMode();
     GL_SetTextureFilter();
 
-    if(devparm) {
+    if(devparm || timingdemo) {
         glBindCalls++;
     }
 
@@ -736,23 +1005,26 @@ static void R_DrawFire(void) {
             firetexture
         );
     }
-    else {
+    else if(fireDirtyHigh >= fireDirtyLow) {
         //
-        // update texture data
+        // update only the rows that changed
         //
         dglTexSubImage2D(
             GL_TEXTURE_2D,
             0,
             0,
-            0,
+            fireDirtyLow,
             FIRESKY_WIDTH,
-            FIRESKY_HEIGHT,
+            (fireDirtyHigh - fireDirtyLow) + 1,
             GL_RGBA,
             GL_UNSIGNED_BYTE,
-            firetexture
+            &firetexture[fireDirtyLow * FIRESKY_WIDTH]
         );
     }
 
+    fireDirtyLow = 0;
+    fireDirtyHigh = -1;
+
     if(r_skybox.value <= 0) {
         SKYVIEWPOS(viewangle, 4, pos1);
 
@@ -769,7 +1041,7 @@ static void R_DrawFire(void) {
         GL_Draw2DQuad(v, 1);
     }
     else {
-        R_DrawSkyDome(16, 1, 1024, 4096, -896, 0.0075f,
+        R_DrawSkyDome(SKYDOME_FIRE, 16, 1, 1024, 4096, -896, 0.0075f,
                       sky->skycolor[0], sky->skycolor[1]);
     }
 }
@@ -807,7 +1079,7 @@ void R_DrawSky(void) {
                 // drawer will assume that the texture's
                 // dimensions is already in powers of 2
                 //
-                R_DrawSkyDome(4, 2, 512, 1024,
+                R_DrawSkyDome(SKYDOME_PIC, 4, 2, 512, 1024,
                               0, 0, WHITE, WHITE);
             }
         }
@@ -847,7 +1119,7 @@ void R_DrawSky(void) {
                 domeheight = (int)(base / (origh / h));
                 offset = (float)domeheight - base - 16.0f;
 
-                R_DrawSkyDome(5, 1, domeheight, 768,
+                R_DrawSkyDome(SKYDOME_BACKDROP, 5, 1, domeheight, 768,
                               offset, 0.005f, WHITE, WHITE);
             }
         }
@@ -46,5 +46,7 @@ extern int          fireLump;
 void R_SkyTicker(void);
 void R_DrawSky(void);
 void R_InitFire(void);
+void R_InitSkyDomes(void);
+void CMD_TestFire(int64 data, char** param);
 
 #endif
\ No newline at end of file
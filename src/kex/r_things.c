@@ -252,12 +252,16 @@ void R_InitSprites(char** namelist) {
 
 void R_AddSprites(subsector_t *sub) {
     mobj_t* thing;
+    int     i;
+    int     end;
+    int     s;
 
-    // Handle all things in sector.
-    for(thing = sub->sector->thinglist; thing; thing = thing->snext) {
-        if(thing->subsector != sub) { // don't add sprite if it doesn't belong in this subsector
-            continue;
-        }
+    // Handle all things in subsector; grouped by P_GroupMobjSlots
+    s = sub - subsectors;
+    end = subsectormobjfirst[s + 1];
+
+    for(i = subsectormobjfirst[s]; i < end; i++) {
+        thing = mobjslotmobj[subsectormobjs[i]];
 
         if(thing->flags & MF_NOSECTOR) {
             continue;
@@ -729,7 +733,7 @@ void R_DrawPSprite(pspdef_t *psp, sector_t* sector, player_t *player) {
 
     GL_ResetViewport();
 
-    if(devparm) {
+    if(devparm || timingdemo) {
         vertCount += 4;
     }
 
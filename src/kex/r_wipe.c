@@ -68,6 +68,10 @@ void WIPE_FadeScreen(int fadetics) {
     vtx_t v[4];
     float left, right, top, bottom;
 
+    if(nodrawparm) {
+        return;
+    }
+
     allowmenu = false;
 
     wipeFadeAlpha = 0xff;
@@ -100,6 +104,7 @@ void WIPE_FadeScreen(int fadetics) {
     v[2].tv = v[3].tv = 0.0f;
 
     dglBindTexture(GL_TEXTURE_2D, wipeMeltTexture);
+    GL_ResetTextures();
 
     //
     // begin fade out
@@ -148,6 +153,10 @@ void WIPE_MeltScreen(void) {
     float left, right, top, bottom;
     int i = 0;
 
+    if(nodrawparm) {
+        return;
+    }
+
     M_ClearMenus();
     allowmenu = false;
 
@@ -182,6 +191,7 @@ void WIPE_MeltScreen(void) {
     dmemcpy(v2, v, sizeof(vtx_t) * 4);
 
     dglBindTexture(GL_TEXTURE_2D, wipeMeltTexture);
+    GL_ResetTextures();
     GL_SetTextureMode(GL_ADD);
 
     for(i = 0; i < 160; i += 2) {
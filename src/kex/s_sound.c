@@ -113,6 +113,12 @@ void S_Init(void) {
         CON_DPrintf("Music disabled\n");
     }
 
+    // no sequencer at all when running headless
+    if(nodrawparm) {
+        nosound = true;
+        nomusic = true;
+    }
+
     if(nosound && nomusic) {
         return;
     }
@@ -128,6 +128,10 @@ typedef    struct {
     plane_t         ceilingplane;
     plane_t         floorplane;
 
+    // [kex] sectors hashed by tag, see P_InitTagLists
+    int             firsttag;
+    int             nexttag;
+
 } sector_t;
 
 
@@ -206,6 +210,10 @@ typedef struct line_s {
 
     angle_t         angle;
 
+    // [kex] lines hashed by tag, see P_InitTagLists
+    int             firsttag;
+    int             nexttag;
+
 } line_t;
 
 
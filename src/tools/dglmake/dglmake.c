@@ -324,6 +324,12 @@ int GetGLType(glinfo_t* info)
     else if(!strcmp(temp, "GLsizeiptr"))
         info->type = 19;
 
+    else if(!strcmp(temp, "GLhandleARB"))
+        info->type = 20;
+
+    else if(!strcmp(temp, "GLcharARB"))
+        info->type = 21;
+
     return 1;
 }
 
@@ -395,6 +401,12 @@ char* ReturnGLType(glinfo_t* info)
     case 19:
         return "GLsizeiptr";
         break;
+    case 20:
+        return "GLhandleARB";
+        break;
+    case 21:
+        return "GLcharARB";
+        break;
     }
 
     return NULL;
@@ -522,6 +534,12 @@ void SlapGLStuffToFile(FILE* f, int count, dboolean addunderscore)
                     break;
                 case 15:
                     break;
+                case 20:
+                    fprintf(f, "%%i");
+                    break;
+                case 21:
+                    fprintf(f, "%%i");
+                    break;
                 }
             }
 
@@ -796,6 +814,9 @@ int main(int argc, char** argv)
     SlapGLExtensionsToFile(f, "GL_ARB_texture_env_combine");
     SlapGLExtensionsToFile(f, "GL_EXT_texture_env_combine");
     SlapGLExtensionsToFile(f, "GL_EXT_texture_filter_anisotropic");
+    SlapGLExtensionsToFile(f, "GL_ARB_shader_objects");
+    SlapGLExtensionsToFile(f, "GL_ARB_vertex_shader");
+    SlapGLExtensionsToFile(f, "GL_ARB_fragment_shader");
 
     fclose(f);
 